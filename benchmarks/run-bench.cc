@@ -1,8 +1,14 @@
 #include "json5cpp.h"
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <chrono>
+#include <thread>
+#include <dirent.h>
 #include <stdlib.h>
 #include <nlohmann/json.hpp>
 
@@ -17,6 +23,49 @@ static void parseJson5Cpp(std::istream &is) {
 	doNotOptimize(v);
 }
 
+__attribute__((noinline))
+static void parseJson5CppReused(std::istream &is) {
+	static Json5::Parser parser;
+	Json::Value v;
+	parser.parse(is, v);
+	doNotOptimize(v);
+}
+
+__attribute__((noinline))
+static void parseJson5CppStrict(std::istream &is) {
+	Json::Value v;
+	Json5::ParseConfig conf;
+	conf.strictJson = true;
+	Json5::parse(is, v, nullptr, conf);
+	doNotOptimize(v);
+}
+
+__attribute__((noinline))
+static void validateJson5Cpp(std::istream &is) {
+	bool ok = Json5::validate(is);
+	doNotOptimize(ok);
+}
+
+__attribute__((noinline))
+static void parseJson5CppUtf8(std::istream &is) {
+	Json::Value v;
+	Json5::ParseConfig conf;
+	conf.validateUtf8 = true;
+	Json5::parse(is, v, nullptr, conf);
+	doNotOptimize(v);
+}
+
+static const std::vector<std::string> selectedPaths = {"/config/database"};
+
+__attribute__((noinline))
+static void parseJson5CppSelected(std::istream &is) {
+	Json::Value v;
+	Json5::ParseConfig conf;
+	conf.paths = &selectedPaths;
+	Json5::parse(is, v, nullptr, conf);
+	doNotOptimize(v);
+}
+
 __attribute__((noinline))
 static void parseJsonCpp(std::istream &is) {
 	Json::Value v;
@@ -73,11 +122,159 @@ static void benchAll(std::string name, std::string &str) {
 
 	std::cout << "Benchmark '" << name << "':\n";
 	std::cout << "Json5Cpp: " << timeToString(benchOne(is, parseJson5Cpp)) << '\n';
+	std::cout << "Json5Cpp (Parser): " << timeToString(benchOne(is, parseJson5CppReused)) << '\n';
+	std::cout << "Json5Cpp (validate): " << timeToString(benchOne(is, validateJson5Cpp)) << '\n';
+	std::cout << "Json5Cpp (strict JSON): " << timeToString(benchOne(is, parseJson5CppStrict)) << '\n';
 	std::cout << "JsonCpp:  " << timeToString(benchOne(is, parseJsonCpp)) << '\n';
 	std::cout << "Nlohmann: " << timeToString(benchOne(is, parseNlohmann)) << '\n';
 	std::cout << '\n';
 }
 
+// For documents which only Json5Cpp can parse
+static void benchJson5(std::string name, std::string &str) {
+	std::stringstream is{std::move(str)};
+	str.clear();
+
+	std::cout << "Benchmark '" << name << "':\n";
+	std::cout << "Json5Cpp: " << timeToString(benchOne(is, parseJson5Cpp)) << '\n';
+	std::cout << "Json5Cpp (Parser): " << timeToString(benchOne(is, parseJson5CppReused)) << '\n';
+	std::cout << "Json5Cpp (validate): " << timeToString(benchOne(is, validateJson5Cpp)) << '\n';
+	std::cout << '\n';
+}
+
+static void benchSelected(std::string name, std::string &str) {
+	std::stringstream is{std::move(str)};
+	str.clear();
+
+	std::cout << "Benchmark '" << name << "':\n";
+	std::cout << "Json5Cpp (full):     " << timeToString(benchOne(is, parseJson5Cpp)) << '\n';
+	std::cout << "Json5Cpp (selected): " << timeToString(benchOne(is, parseJson5CppSelected)) << '\n';
+	std::cout << '\n';
+}
+
+static void benchUtf8(std::string name, std::string &str) {
+	std::stringstream is{std::move(str)};
+	str.clear();
+
+	std::cout << "Benchmark '" << name << "':\n";
+	std::cout << "Json5Cpp:                " << timeToString(benchOne(is, parseJson5Cpp)) << '\n';
+	std::cout << "Json5Cpp (validateUtf8): " << timeToString(benchOne(is, parseJson5CppUtf8)) << '\n';
+	std::cout << '\n';
+}
+
+static void benchBatch(std::string name, const std::string &doc) {
+	std::vector<Json5::Buffer> docs(100000, Json5::Buffer{doc.data(), doc.size()});
+
+	auto docsPerSec = [&](unsigned int threads) {
+		auto start = std::chrono::steady_clock::now();
+		std::vector<Json5::ParseResult> results =
+			Json5::parseBatch(docs.data(), docs.size(), {}, threads);
+		doNotOptimize(results);
+		std::chrono::duration<double> delta = std::chrono::steady_clock::now() - start;
+		return std::to_string(int(docs.size() / delta.count())) + " docs/s";
+	};
+
+	std::cout << "Benchmark '" << name << "':\n";
+	std::cout << "Json5Cpp (parseBatch, 1 thread):  " << docsPerSec(1) << '\n';
+	std::cout << "Json5Cpp (parseBatch, all cores): " << docsPerSec(0) << '\n';
+	std::cout << '\n';
+}
+
+// The mutex guarded document SharedDocument replaces
+struct LockedDocument {
+	std::mutex mut;
+	std::shared_ptr<const Json::Value> doc = std::make_shared<const Json::Value>();
+
+	std::shared_ptr<const Json::Value> get() {
+		std::lock_guard<std::mutex> lock(mut);
+		return doc;
+	}
+
+	void reload(const std::string &str) {
+		auto v = std::make_shared<Json::Value>();
+		Json5::parse(str.data(), str.size(), *v);
+		std::lock_guard<std::mutex> lock(mut);
+		doc = std::move(v);
+	}
+};
+
+// Read from several threads while the document is reloaded over and over
+template<typename Doc, typename Reload>
+static std::string readsPerSec(Doc &doc, Reload reload) {
+	unsigned int numReaders = std::max(2u, std::thread::hardware_concurrency()) - 1;
+	std::atomic<bool> done{false};
+	std::atomic<long long> reads{0};
+	std::vector<std::thread> readers;
+	for (unsigned int i = 0; i < numReaders; ++i) {
+		readers.emplace_back([&] {
+			long long n = 0;
+			while (!done.load(std::memory_order_relaxed)) {
+				std::shared_ptr<const Json::Value> v = doc.get();
+				doNotOptimize(v);
+				n += 1;
+			}
+			reads += n;
+		});
+	}
+
+	int reloads = 0;
+	auto start = std::chrono::steady_clock::now();
+	std::chrono::duration<double> delta;
+	do {
+		reload();
+		reloads += 1;
+		delta = std::chrono::steady_clock::now() - start;
+	} while (delta.count() < 0.5);
+
+	done = true;
+	for (std::thread &t: readers) {
+		t.join();
+	}
+
+	return std::to_string((long long)(reads / delta.count())) + " reads/s, " +
+		std::to_string((int)(reloads / delta.count())) + " reloads/s";
+}
+
+static void benchShared(std::string name, const std::string &str) {
+	Json5::SharedDocument shared;
+	LockedDocument locked;
+
+	std::cout << "Benchmark '" << name << "':\n";
+	std::cout << "Json5Cpp (SharedDocument): " << readsPerSec(shared, [&] {
+		shared.reload(str.data(), str.size());
+	}) << '\n';
+	std::cout << "Mutex guarded:             " << readsPerSec(locked, [&] {
+		locked.reload(str);
+	}) << '\n';
+	std::cout << '\n';
+}
+
+// The worst cases found by the performance fuzzer (see fuzz/perf-fuzz.cc)
+static void benchPathological(const std::string &dir) {
+	DIR *d = opendir(dir.c_str());
+	if (!d) {
+		std::cerr << "Couldn't open " << dir << ", skipping pathological inputs\n";
+		return;
+	}
+
+	std::vector<std::string> names;
+	while (struct dirent *ent = readdir(d)) {
+		if (ent->d_name[0] != '.') {
+			names.push_back(ent->d_name);
+		}
+	}
+	closedir(d);
+	std::sort(names.begin(), names.end());
+
+	for (const std::string &name: names) {
+		std::ifstream is(dir + "/" + name, std::ios::binary);
+		std::stringstream ss;
+		ss << is.rdbuf();
+		std::string json = ss.str();
+		benchJson5("Pathological: " + name, json);
+	}
+}
+
 int main() {
 	std::string json = "[]";
 	benchAll("Tiny", json);
@@ -115,6 +312,53 @@ int main() {
 	json += "}";
 	benchAll("Big Object Of Numbers", json);
 
+	json = "[\n";
+	for (int i = 0; i < 20000; ++i) {
+		json += "\t{\n";
+		json += "\t\tfirstName: 'Ada', lastName: 'Lovelace', // Bare keys everywhere\n";
+		json += "\t\tisActive: true, favoriteColor: null, loginCount: 0x" + std::to_string(i) + ",\n";
+		json += "\t\tratio: Infinity, score: NaN, nested: {alpha: true, beta: false, gamma: null},\n";
+		json += "\t},\n";
+	}
+	json += "]";
+	benchJson5("Bare Identifiers (JSON5 only)", json);
+
+	benchBatch("Batch Of Tiny", "[]");
+
 	json = R"({"oid":"6e1ef259b54c3639440c970bb0c438e0064bb4f4","url":"/mortie/json5cpp/commit/6e1ef259b54c3639440c970bb0c438e0064bb4f4","date":"2023-07-21T21:58:51.000+02:00","shortMessageHtmlLink":"<a data-pjax=\"true\" title=\"improve and flesh out tests\" class=\"Link--secondary\" href=\"/mortie/json5cpp/commit/6e1ef259b54c3639440c970bb0c438e0064bb4f4\">improve and flesh out tests</a>","bodyMessageHtml":"","author":{"displayName":"Martin Dørum","login":"mortie","path":"/mortie","avatarUrl":"https://avatars.githubusercontent.com/u/3728194?s=40&v=4"},"status":null,"isSpoofed":false})";
+	benchBatch("Batch Of GitHub REST Responses", json);
+	benchShared("Shared Config Reads During Reloads", json);
 	benchAll("GitHub REST Response", json);
+
+	json = "{\"data\": [";
+	for (int i = 0; i < 20000; ++i) {
+		json += "{\"id\": " + std::to_string(i) + ", \"name\": \"Item " + std::to_string(i);
+		json += "\", \"price\": " + std::to_string(i * 0.25) + ", \"tags\": [\"a\", \"b\"]},";
+	}
+	json += "{}], \"config\": {\"database\": {\"host\": \"localhost\", \"port\": 5432}}}";
+	benchSelected("Path Filtered", json);
+
+	json = "[\n";
+	for (int i = 0; i < 2000; ++i) {
+		json += "\t\"";
+		for (int j = 0; j < 20; ++j) {
+			json += "Bl\u00e5b\u00e6rsyltet\u00f8y, \u65e5\u672c\u8a9e\u306e\u30c6\u30ad\u30b9\u30c8, "
+				"\u041f\u0440\u0438\u0432\u0435\u0442 \U0001F600 ";
+		}
+		json += std::to_string(i) + "\",\n";
+	}
+	json += "\t\"ascii\"\n]";
+	benchUtf8("Non-ASCII Strings", json);
+	json = "[\n";
+	for (int i = 0; i < 2000; ++i) {
+		json += "\t\"";
+		for (int j = 0; j < 20; ++j) {
+			json += "Mostly ASCII text, with the odd caf\u00e9 or \u20ac in it. ";
+		}
+		json += std::to_string(i) + "\",\n";
+	}
+	json += "\t\"ascii\"\n]";
+	benchUtf8("Mostly ASCII Strings", json);
+
+	benchPathological("../fuzz/perf-corpus");
 }
@@ -0,0 +1,250 @@
+// Performance regression fuzzer.
+//
+// Every input is parsed with Json5::parse under a few configs (the default,
+// 'paths' selecting nothing so that everything goes through skipValue,
+// 'strictJson', 'newlinesAsCommas' and 'rawNumbers'), and the input is flagged
+// if a parse takes too long or allocates too much for its size.
+// The budget is linear in the size of the input, so anything which makes
+// the parser go quadratic (or just really slow) on some input gets caught.
+// An input which takes longer than the timeout in total is reported as a hang.
+//
+// Build with 'clang++ -fsanitize=fuzzer' to run it under libFuzzer,
+// or with '-DPERF_FUZZ_STANDALONE' to just check the files given on the command line.
+//
+// The budgets can be changed with these environment variables:
+// * JSON5_PERF_NS_PER_BYTE: Nanoseconds of parse time per byte (default 1000)
+// * JSON5_PERF_ALLOCS_PER_BYTE: Allocations per byte (default 2)
+// * JSON5_PERF_BASE_BYTES: Added to the size of every input,
+//   so that tiny inputs get some slack (default 64)
+// * JSON5_PERF_TIMEOUT: Seconds allowed for all the parses of one input (default 10)
+
+#include "json5cpp.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <thread>
+#include <stdint.h>
+#include <stdlib.h>
+
+static std::atomic<size_t> numAllocs{0};
+
+void *operator new(size_t size) {
+	numAllocs.fetch_add(1, std::memory_order_relaxed);
+	void *ptr = malloc(size ? size : 1);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+static double envOr(const char *name, double def) {
+	const char *val = getenv(name);
+	return val ? atof(val) : def;
+}
+
+struct Budget {
+	double nsPerByte = envOr("JSON5_PERF_NS_PER_BYTE", 1000);
+	double allocsPerByte = envOr("JSON5_PERF_ALLOCS_PER_BYTE", 2);
+	double baseBytes = envOr("JSON5_PERF_BASE_BYTES", 64);
+	double timeout = envOr("JSON5_PERF_TIMEOUT", 10);
+};
+
+struct Config {
+	const char *name;
+	Json5::ParseConfig conf;
+};
+
+static std::vector<Config> makeConfigs() {
+	// Selects nothing, so every value is skipped rather than parsed
+	static const std::vector<std::string> nothing = {"/nothing"};
+
+	std::vector<Config> configs(5);
+	configs[0].name = "default";
+	configs[1].name = "paths";
+	configs[1].conf.paths = &nothing;
+	configs[2].name = "strictJson";
+	configs[2].conf.strictJson = true;
+	configs[3].name = "newlinesAsCommas";
+	configs[3].conf.newlinesAsCommas = true;
+	configs[4].name = "rawNumbers";
+	configs[4].conf.rawNumbers = true;
+	return configs;
+}
+
+static const std::vector<Config> configs = makeConfigs();
+
+// Aborts the process if an input is still being parsed after its deadline.
+// A hung parse never returns to be measured, so this is the only way to report it.
+class Watchdog {
+public:
+	explicit Watchdog(double seconds): timeout_(seconds * 1e9) {
+		std::thread([this] { run(); }).detach();
+	}
+
+	void arm(size_t size) {
+		size_.store(size, std::memory_order_relaxed);
+		config_.store("", std::memory_order_relaxed);
+		deadline_.store(now() + timeout_, std::memory_order_release);
+	}
+
+	void running(const char *config) {
+		config_.store(config, std::memory_order_relaxed);
+	}
+
+	void disarm() {
+		deadline_.store(0, std::memory_order_release);
+	}
+
+private:
+	static int64_t now() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void run() {
+		std::chrono::milliseconds interval(std::max<int64_t>(1, std::min<int64_t>(100, timeout_ / 10000000)));
+		while (true) {
+			std::this_thread::sleep_for(interval);
+			int64_t deadline = deadline_.load(std::memory_order_acquire);
+			if (deadline != 0 && now() > deadline) {
+				std::cerr
+					<< "Input of " << size_.load(std::memory_order_relaxed)
+					<< " bytes timed out (config: " << config_.load(std::memory_order_relaxed) << ")\n";
+				abort();
+			}
+		}
+	}
+
+	int64_t timeout_;
+	std::atomic<int64_t> deadline_{0};
+	std::atomic<size_t> size_{0};
+	std::atomic<const char *> config_{""};
+};
+
+struct Cost {
+	double ns = 0;
+	size_t allocs = 0;
+	const char *slowest = ""; // The config which took the most time
+	const char *hungriest = ""; // The config which made the most allocations
+};
+
+static Cost measure(const char *data, size_t size, const Json5::ParseConfig &conf) {
+	size_t allocsBefore = numAllocs.load(std::memory_order_relaxed);
+	auto start = std::chrono::steady_clock::now();
+	{
+		Json::Value v;
+		Json5::parse(data, size, v, nullptr, conf);
+	}
+	std::chrono::duration<double, std::nano> delta = std::chrono::steady_clock::now() - start;
+	Cost cost;
+	cost.ns = delta.count();
+	cost.allocs = numAllocs.load(std::memory_order_relaxed) - allocsBefore;
+	return cost;
+}
+
+// Returns an empty string if the input is within budget under every config,
+// or a description of what went over budget.
+// 'cost' is set to the worst time and allocation count across the configs.
+static std::string check(const char *data, size_t size, Cost &cost) {
+	static const Budget budget;
+	static Watchdog watchdog(budget.timeout);
+	double bytes = size + budget.baseBytes;
+
+	cost = Cost();
+	std::string why;
+	watchdog.arm(size);
+	for (const Config &config: configs) {
+		watchdog.running(config.name);
+
+		// Timing is noisy, so only the fastest of a few runs counts
+		Cost c = measure(data, size, config.conf);
+		for (int i = 0; i < 4 && c.ns > bytes * budget.nsPerByte; ++i) {
+			c.ns = std::min(c.ns, measure(data, size, config.conf).ns);
+		}
+
+		if (c.ns > cost.ns) {
+			cost.ns = c.ns;
+			cost.slowest = config.name;
+		}
+
+		if (c.allocs > cost.allocs) {
+			cost.allocs = c.allocs;
+			cost.hungriest = config.name;
+		}
+
+		if (c.ns > bytes * budget.nsPerByte) {
+			why += why.empty() ? "" : ", ";
+			why += std::string("too slow with ") + config.name + ": " +
+				std::to_string(c.ns / size) + " ns/byte";
+		}
+
+		if (c.allocs > bytes * budget.allocsPerByte) {
+			why += why.empty() ? "" : ", ";
+			why += std::string("too many allocations with ") + config.name + ": " +
+				std::to_string((double)c.allocs / size) + " allocs/byte";
+		}
+	}
+	watchdog.disarm();
+
+	return why;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	Cost cost;
+	std::string why = check((const char *)data, size, cost);
+	if (!why.empty()) {
+		std::cerr << "Input of " << size << " bytes is " << why << '\n';
+		abort();
+	}
+
+	return 0;
+}
+
+#ifdef PERF_FUZZ_STANDALONE
+int main(int argc, char **argv) {
+	bool failed = false;
+	for (int i = 1; i < argc; ++i) {
+		std::ifstream is(argv[i], std::ios::binary);
+		if (!is) {
+			std::cerr << argv[i] << ": Couldn't open file\n";
+			failed = true;
+			continue;
+		}
+
+		std::stringstream ss;
+		ss << is.rdbuf();
+		std::string input = ss.str();
+
+		Cost cost;
+		std::string why = check(input.data(), input.size(), cost);
+		double size = std::max<size_t>(input.size(), 1);
+		std::cout
+			<< argv[i] << ": " << input.size() << " bytes, "
+			<< (cost.ns / size) << " ns/byte (" << cost.slowest << "), "
+			<< (cost.allocs / size) << " allocs/byte (" << cost.hungriest << ")";
+		if (why.empty()) {
+			std::cout << '\n';
+		} else {
+			std::cout << " (" << why << ")\n";
+			failed = true;
+		}
+
+		// So that the watchdog's report comes after the last file that finished
+		std::cout.flush();
+	}
+
+	return failed ? 1 : 0;
+}
+#endif
@@ -26,25 +26,193 @@
 #define JSON5CPP_H
 
 #include <json/json.h>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <stdint.h>
 #include <string>
+#include <type_traits>
+#include <vector>
+
+// Whether the POSIX file, memory mapping and directory APIs are available.
+// Define it to 0 or 1 before including json5cpp.h to override the detection.
+#ifndef JSON5CPP_POSIX
+#if defined(__unix__) || defined(__APPLE__)
+#define JSON5CPP_POSIX 1
+#else
+#define JSON5CPP_POSIX 0
+#endif
+#endif
 
 #ifndef JSON5CPP_FWD_ONLY
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <istream>
 #include <limits>
-#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <thread>
+
+#if JSON5CPP_POSIX
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#endif
+
+#if defined(JSON5CPP_ZLIB) && !defined(JSON5CPP_FWD_ONLY)
+#include <zlib.h>
 #endif
 
 namespace Json5 {
 
+// What went wrong, for tools which handle errors without parsing the message.
+// errorMessage gives the message which the string errors use.
+enum ErrorCode {
+	ERROR_NONE,
+	ERROR_IO, // A file couldn't be opened or read
+	ERROR_UNEXPECTED_EOF,
+	ERROR_TRAILING_GARBAGE,
+	ERROR_DEPTH_LIMIT,
+	ERROR_INVALID_KEYWORD,
+	ERROR_INVALID_NUMBER,
+	ERROR_INVALID_IDENTIFIER_START,
+	ERROR_INVALID_ESCAPE,
+	ERROR_INVALID_HEX,
+	ERROR_EXPECTED_TRAILING_SURROGATE,
+	ERROR_INVALID_TRAILING_SURROGATE,
+	ERROR_INVALID_UTF8,
+	ERROR_UNESCAPED_LINE_TERMINATOR,
+	ERROR_UNESCAPED_CONTROL_CHARACTER,
+	ERROR_EXPECTED_KEY,
+	ERROR_EXPECTED_KEY_OR_BRACE,
+	ERROR_EXPECTED_STRING_KEY,
+	ERROR_EXPECTED_COLON,
+	ERROR_EXPECTED_VALUE,
+	ERROR_EXPECTED_VALUE_OR_BRACKET,
+	ERROR_EXPECTED_COMMA_OR_BRACE,
+	ERROR_EXPECTED_COMMA_OR_BRACKET,
+	ERROR_EXPECTED_COMMA_NEWLINE_OR_BRACE,
+	ERROR_EXPECTED_COMMA_NEWLINE_OR_BRACKET,
+	ERROR_INVALID_PATHS,
+	ERROR_INVALID_COMPRESSED_DATA,
+	ERROR_INVALID_EDIT,
+};
+
+// Like "Unexpected EOF" for ERROR_UNEXPECTED_EOF
+const char *errorMessage(ErrorCode code);
+
+struct ParseError {
+	ErrorCode code = ERROR_NONE;
+	size_t offset = 0; // The byte offset in the input
+	int line = 0; // Starting at 1, like 'column'
+	int column = 0; // In bytes
+};
+
+// Where the values of a document are in the input, for tools like linters
+// and editors which need to map values back to the source without parsing it again.
+// Filled in during a parse with 'conf.sourceMap'; pointers to values stay valid
+// for as long as the parsed Json::Value isn't modified.
+struct SourceMap {
+	struct Span {
+		const Json::Value *value;
+		size_t start; // The offset of the value's first byte
+		size_t limit; // The offset just past its last byte
+		size_t parent; // The index of the containing value's span, SIZE_MAX for the root
+	};
+
+	// Every value in the document, in the order they start in the input.
+	// A value's children follow it, so the spans are sorted by 'start'.
+	// Values which were replaced by a later duplicate key have a null 'value'.
+	std::vector<Span> spans;
+
+	// The offset where each line starts; line 1 starts at 'lines[0]'
+	std::vector<size_t> lines;
+
+	// The innermost value which contains the byte at 'offset', or nullptr
+	const Span *find(size_t offset) const;
+
+	// The span of a value, or nullptr if it isn't from this document
+	const Span *find(const Json::Value &v) const;
+
+	// Convert an offset to a line and a column, both starting at 1
+	void position(size_t offset, int &line, int &column) const;
+};
+
 struct ParseConfig {
 	// Whether or not to accept newlines instead of commas
 	// between object/array elements.
 	// Note: Setting this to 'true' enables invalid JSON5.
 	bool newlinesAsCommas = false;
 
+	// Whether or not to only accept standard JSON (RFC 8259),
+	// rejecting comments, single quotes, bare keys, trailing commas,
+	// hex numbers, Infinity, NaN and the other JSON5 extensions.
+	// 'newlinesAsCommas' is ignored when this is set.
+	bool strictJson = false;
+
 	// The maximum parse depth, to avoid unbounded recursion.
 	int maxDepth = 100;
+
+	// If set, only the subtrees at these JSON pointer paths
+	// (like "/config/database" or "/servers/0") are parsed into the result.
+	// Everything else is validated and skipped, without being decoded or allocated.
+	// Skipped array elements before a selected element become null.
+	const std::vector<std::string> *paths = nullptr;
+
+	// Whether or not to record the byte offsets of each value in the input,
+	// available through Json::Value::getOffsetStart() and getOffsetLimit().
+	// Json5::reparse needs this.
+	bool recordOffsets = false;
+
+	// Whether or not to reject strings and identifiers which aren't valid UTF-8.
+	// Overlong encodings, surrogates and code points above U+10FFFF are invalid.
+	bool validateUtf8 = false;
+
+	// Whether or not to keep numbers as their source text,
+	// instead of converting each one to an int or a double.
+	// Raw numbers are string values; use Json5::isRawNumber to recognize them
+	// and Json5::convertNumber to convert them when they're needed.
+	// Serializing a raw number writes its text as is, so big integers
+	// and exact decimals make it through a round trip unchanged.
+	bool rawNumbers = false;
+
+	// Whether or not to parse the document onto the value which is already there,
+	// instead of replacing it. Objects are merged key by key, recursively;
+	// everything else, including arrays, replaces the existing value.
+	// This makes loading a base config followed by override files cheap,
+	// since nothing is parsed into a separate tree and copied.
+	// If parsing fails, the value is left partially merged.
+	// Json5::reparse ignores this.
+	bool merge = false;
+
+	// If set, receives the code and position of the error when parsing fails,
+	// and is left alone otherwise. It doesn't depend on 'err', so pass nullptr
+	// as 'err' to not spend any time formatting error messages.
+	// parseBatch and loadDirectory put the error in each ParseResult instead,
+	// and FileCache and SharedDocument ignore this.
+	ParseError *error = nullptr;
+
+	// If set, it's cleared and filled in with where each value came from,
+	// which also turns on 'recordOffsets'. Json5::validate only fills in 'lines'.
+	// parseBatch, loadDirectory, FileCache, SharedDocument and reparse ignore this.
+	SourceMap *sourceMap = nullptr;
 };
 
 struct SerializeConfig {
@@ -58,16 +226,590 @@ struct SerializeConfig {
 	// The string used for each level of nesting.
 	// Set to 'nullptr' to avoid whitespace completely.
 	const char *indent = "\t";
+
+	// The number of threads used to serialize big objects/arrays.
+	// Set to 0 to use one thread per CPU core.
+	unsigned int threads = 1;
+
+	// The number of children an object/array needs to have
+	// to be split across threads.
+	// Objects/arrays inside one which is split up aren't split up themselves.
+	unsigned int parallelThreshold = 4096;
 };
 
 bool parse(
 		std::istream &is, Json::Value &v,
 		std::string *err = nullptr, ParseConfig conf = {});
 
+// Parse a document which is already in memory.
+bool parse(
+		const char *data, size_t size, Json::Value &v,
+		std::string *err = nullptr, ParseConfig conf = {});
+
+// Update 'v' after an edit to the document 'text' it was parsed from,
+// re-parsing only the smallest value which contains the edit.
+// The edit replaces 'removed' bytes at 'offset' with 'inserted',
+// and is applied to 'text' too.
+// 'v' must come from parsing 'text' with 'conf.recordOffsets';
+// if the edit changes the structure around the value, or 'v' has no offsets,
+// the whole document is parsed again.
+// On error, 'v' is set to null, so that the next reparse does a full parse.
+bool reparse(
+		std::string &text, Json::Value &v,
+		size_t offset, size_t removed, const std::string &inserted,
+		std::string *err = nullptr, ParseConfig conf = {});
+
+// Read and parse a whole file.
+bool parseFile(
+		const std::string &path, Json::Value &v,
+		std::string *err = nullptr, ParseConfig conf = {});
+
+// Check whether the input is valid JSON5, without building a Json::Value.
+// Accepts exactly the documents 'parse' accepts, with the same error messages.
+// 'conf.paths' is ignored; the whole document is validated.
+bool validate(
+		std::istream &is,
+		std::string *err = nullptr, ParseConfig conf = {});
+
 void serialize(
 		std::ostream &os, const Json::Value &v,
 		SerializeConfig conf = {}, int depth = 0);
 
+// Whether 'v' is a number parsed with 'conf.rawNumbers'.
+// Its text, like "0x1F" or "12345678901234567890", is 'v.asString()'.
+bool isRawNumber(const Json::Value &v);
+
+// Convert a raw number to an int, uint or double value,
+// exactly like parse would have without 'conf.rawNumbers'.
+// Anything else is returned as is.
+Json::Value convertNumber(const Json::Value &v);
+
+namespace detail {
+struct ParserState;
+struct FileCacheState;
+struct SharedDocumentState;
+struct DeflateBuf;
+}
+
+// A reusable parser, for when you parse lots of documents.
+// It keeps its buffers, number parser and compiled 'conf.paths'
+// around between documents, so each parse has less setup cost
+// than a call to Json5::parse.
+// A Parser must only be used by one thread at a time,
+// but separate Parser objects can be used concurrently,
+// so keeping one Parser per thread is safe.
+// 'conf.paths' is read when the Parser is constructed.
+class Parser {
+public:
+	Parser(ParseConfig conf = {});
+	Parser(Parser &&other);
+	Parser &operator=(Parser &&other);
+	~Parser();
+
+	bool parse(std::istream &is, Json::Value &v, std::string *err = nullptr);
+	bool parse(
+			const char *data, size_t size, Json::Value &v,
+			std::string *err = nullptr);
+	bool validate(std::istream &is, std::string *err = nullptr);
+	bool validate(const char *data, size_t size, std::string *err = nullptr);
+
+private:
+	std::unique_ptr<detail::ParserState> state_;
+};
+
+// Caches parsed files, so that getting a file which hasn't changed
+// since last time doesn't parse it again.
+// A file is considered unchanged if its size and modification time are the same.
+// With 'hashContents', the file is also read and hashed when it looks unchanged,
+// which catches changes too quick for the modification time to show,
+// at the cost of reading the file. Without JSON5CPP_POSIX, files are always hashed.
+// All methods are thread safe.
+class FileCache {
+public:
+	FileCache(ParseConfig conf = {}, bool hashContents = false);
+	~FileCache();
+
+	// Returns nullptr on error.
+	// The returned value is shared with other users of the cache,
+	// and stays valid even if the cache entry is replaced.
+	std::shared_ptr<const Json::Value> get(
+			const std::string &path, std::string *err = nullptr);
+
+	void invalidate(const std::string &path);
+	void clear();
+
+private:
+	std::unique_ptr<detail::FileCacheState> state_;
+};
+
+// A document which many threads read while it's replaced now and then,
+// like a configuration which is reloaded when its file changes.
+// Reading never takes a lock: readers announce themselves in one of
+// two counters, and a replaced document is only released once
+// the counter the readers which could have seen it use drops to zero.
+// New documents are parsed off to the side, so reading isn't held up by parsing.
+// All methods are thread safe. It starts out with a null document.
+class SharedDocument {
+public:
+	SharedDocument(ParseConfig conf = {});
+	~SharedDocument();
+
+	// The current document. It stays valid and unchanged for as long as
+	// it's held, even after it's replaced.
+	std::shared_ptr<const Json::Value> get() const;
+
+	// Parse a new document and make it the current one.
+	// On error, the current document is kept.
+	bool reload(const char *data, size_t size, std::string *err = nullptr);
+	bool reload(std::istream &is, std::string *err = nullptr);
+	bool reloadFile(const std::string &path, std::string *err = nullptr);
+
+	// Make an already parsed document the current one
+	void set(std::shared_ptr<const Json::Value> doc);
+
+private:
+	std::unique_ptr<detail::SharedDocumentState> state_;
+};
+
+// A document in memory, for parseBatch
+struct Buffer {
+	const char *data;
+	size_t size;
+};
+
+struct ParseResult {
+	Json::Value value;
+	std::string err; // The error message, if 'ok' is false
+	ParseError error; // The error's code and position, if 'ok' is false
+	bool ok = false;
+};
+
+// Parse many documents, amortizing the setup cost across all of them.
+// With 'threads' > 1, the documents are spread across that many threads,
+// each with its own Parser. Use 0 for one thread per CPU core.
+// Results are in the same order as 'docs'.
+std::vector<ParseResult> parseBatch(
+		const Buffer *docs, size_t count,
+		ParseConfig conf = {}, unsigned int threads = 1);
+
+#if JSON5CPP_POSIX
+// Read and parse every file in a directory and its subdirectories,
+// like a directory of configuration files. Only available with JSON5CPP_POSIX.
+// Files are spread across 'threads' threads, each with its own Parser.
+// Use 0 for one thread per CPU core.
+// With an 'extension' like ".json5", only files whose name ends with it are loaded.
+// Hidden files and directories are skipped, and so are symlinks to directories.
+// Results are keyed by path, which is 'dir' followed by the path within it.
+// Files (and directories) which couldn't be read or parsed
+// get a result with 'ok' set to false.
+std::map<std::string, ParseResult> loadDirectory(
+		const std::string &dir, ParseConfig conf = {},
+		unsigned int threads = 0, const std::string &extension = "");
+#endif
+
+#ifdef JSON5CPP_ZLIB
+// Parse a gzip (or zlib) compressed document.
+// The input is decompressed in small chunks as it's parsed,
+// so the decompressed document is never in memory all at once.
+// With JSON5CPP_ZLIB defined, parseFile and FileCache also
+// decompress gzip files transparently.
+bool parseGzip(
+		std::istream &is, Json::Value &v,
+		std::string *err = nullptr, ParseConfig conf = {});
+
+// An output stream which gzip compresses everything written to it
+// into another stream, for use with serialize or Writer.
+// The output is only complete once 'finish' is called,
+// which the destructor also does.
+class GzipOStream: public std::ostream {
+public:
+	// 'level' is the zlib compression level, from 0 to 9; -1 is zlib's default
+	GzipOStream(std::ostream &os, int level = -1);
+	~GzipOStream();
+
+	// Returns false if compressing or writing failed
+	bool finish();
+
+private:
+	std::unique_ptr<detail::DeflateBuf> buf_;
+};
+#endif
+
+// Specialize Fields<T> to make your own types serializable
+// with the typed serialize function below.
+// The 'visit' function should call 'f(key, member)' for each member,
+// in the order they should be emitted. For example:
+//
+//     namespace Json5 {
+//     template<>
+//     struct Fields<Point> {
+//         template<typename F>
+//         static void visit(const Point &p, F &f) {
+//             f("x", p.x);
+//             f("y", p.y);
+//         }
+//     };
+//     }
+template<typename T>
+struct Fields;
+
+namespace detail {
+
+void serializeValue(
+		std::ostream &os, const Json::Value &v,
+		const SerializeConfig &conf, int depth);
+void serializeStringLiteral(std::ostream &os, const char *ident);
+void serializeIdentifier(
+		std::ostream &os, const char *ident,
+		const SerializeConfig &conf);
+void serializeNewLine(
+		std::ostream &os, const SerializeConfig &conf, int depth);
+
+// Structs, through Json5::Fields<T>
+template<typename T, typename Enable = void>
+struct TypedSerializer {
+	static void serialize(
+			std::ostream &os, const T &v,
+			const SerializeConfig &conf, int depth);
+};
+
+struct TypedFieldSerializer {
+	std::ostream &os;
+	const SerializeConfig &conf;
+	int depth;
+	bool first;
+
+	template<typename V>
+	void operator()(const char *key, const V &val) {
+		if (!first) {
+			os << ',';
+		}
+		first = false;
+
+		serializeNewLine(os, conf, depth + 1);
+
+		serializeIdentifier(os, key, conf);
+		if (conf.indent == nullptr) {
+			os << ":";
+		} else {
+			os << ": ";
+		}
+
+		TypedSerializer<V>::serialize(os, val, conf, depth + 1);
+	}
+};
+
+template<typename T, typename Enable>
+void TypedSerializer<T, Enable>::serialize(
+		std::ostream &os, const T &v,
+		const SerializeConfig &conf, int depth) {
+	os << '{';
+	TypedFieldSerializer f{os, conf, depth, true};
+	Fields<T>::visit(v, f);
+
+	if (!f.first) {
+		if (conf.trailingCommas) {
+			os << ',';
+		}
+
+		serializeNewLine(os, conf, depth);
+	}
+
+	os << '}';
+}
+
+template<>
+struct TypedSerializer<bool> {
+	static void serialize(
+			std::ostream &os, bool v,
+			const SerializeConfig &, int) {
+		os << (v ? "true" : "false");
+	}
+};
+
+template<typename T>
+struct TypedSerializer<T, typename std::enable_if<
+		std::is_integral<T>::value && std::is_signed<T>::value>::type> {
+	static void serialize(
+			std::ostream &os, T v,
+			const SerializeConfig &, int) {
+		os << (long long)v;
+	}
+};
+
+template<typename T>
+struct TypedSerializer<T, typename std::enable_if<
+		std::is_integral<T>::value && std::is_unsigned<T>::value>::type> {
+	static void serialize(
+			std::ostream &os, T v,
+			const SerializeConfig &, int) {
+		os << (unsigned long long)v;
+	}
+};
+
+template<typename T>
+struct TypedSerializer<T, typename std::enable_if<
+		std::is_floating_point<T>::value>::type> {
+	static void serialize(
+			std::ostream &os, T v,
+			const SerializeConfig &, int) {
+		// Format doubles exactly like jsoncpp does,
+		// so that the output matches serializing a Json::Value
+		os << Json::valueToString(double(v));
+	}
+};
+
+template<>
+struct TypedSerializer<std::string> {
+	static void serialize(
+			std::ostream &os, const std::string &v,
+			const SerializeConfig &, int) {
+		serializeStringLiteral(os, v.c_str());
+	}
+};
+
+template<>
+struct TypedSerializer<const char *> {
+	static void serialize(
+			std::ostream &os, const char *v,
+			const SerializeConfig &, int) {
+		serializeStringLiteral(os, v);
+	}
+};
+
+template<size_t N>
+struct TypedSerializer<char[N]> {
+	static void serialize(
+			std::ostream &os, const char *v,
+			const SerializeConfig &, int) {
+		serializeStringLiteral(os, v);
+	}
+};
+
+template<>
+struct TypedSerializer<Json::Value> {
+	static void serialize(
+			std::ostream &os, const Json::Value &v,
+			const SerializeConfig &conf, int depth) {
+		serializeValue(os, v, conf, depth);
+	}
+};
+
+template<typename T, typename Alloc>
+struct TypedSerializer<std::vector<T, Alloc>> {
+	static void serialize(
+			std::ostream &os, const std::vector<T, Alloc> &v,
+			const SerializeConfig &conf, int depth) {
+		os << '[';
+		bool first = true;
+		for (const auto &elem: v) {
+			if (!first) {
+				os << ',';
+			}
+			first = false;
+
+			serializeNewLine(os, conf, depth + 1);
+			TypedSerializer<T>::serialize(os, elem, conf, depth + 1);
+		}
+
+		if (!first) {
+			if (conf.trailingCommas) {
+				os << ',';
+			}
+
+			serializeNewLine(os, conf, depth);
+		}
+
+		os << ']';
+	}
+};
+
+template<typename T, typename Compare, typename Alloc>
+struct TypedSerializer<std::map<std::string, T, Compare, Alloc>> {
+	static void serialize(
+			std::ostream &os, const std::map<std::string, T, Compare, Alloc> &v,
+			const SerializeConfig &conf, int depth) {
+		os << '{';
+		TypedFieldSerializer f{os, conf, depth, true};
+		for (const auto &kv: v) {
+			f(kv.first.c_str(), kv.second);
+		}
+
+		if (!f.first) {
+			if (conf.trailingCommas) {
+				os << ',';
+			}
+
+			serializeNewLine(os, conf, depth);
+		}
+
+		os << '}';
+	}
+};
+
+}
+
+// Serialize a C++ value directly, without building a Json::Value first.
+// Supports bool, integers, floating point numbers, strings, Json::Value,
+// std::vector, std::map with string keys,
+// and any type which has a Json5::Fields specialization.
+template<typename T>
+void serialize(
+		std::ostream &os, const T &v,
+		SerializeConfig conf = {}, int depth = 0) {
+	detail::TypedSerializer<T>::serialize(os, v, conf, depth);
+}
+
+// Write a document piece by piece, without building it in memory first.
+// Calls must be properly nested, and every value in an object
+// must be preceded by a call to 'key'. The output is identical to
+// serializing the equivalent Json::Value, and only the nesting state
+// is kept in memory, so arbitrarily big documents can be written.
+class Writer {
+public:
+	Writer(std::ostream &os, SerializeConfig conf = {}, int depth = 0);
+
+	void beginObject();
+	void endObject();
+	void beginArray();
+	void endArray();
+
+	void key(const char *key);
+	void key(const std::string &key) { this->key(key.c_str()); }
+
+	// Write a value; anything the typed serialize function supports works
+	template<typename T>
+	void value(const T &v) {
+		beginValue();
+		detail::TypedSerializer<T>::serialize(os_, v, conf_, depth());
+	}
+
+private:
+	struct Level {
+		char close;
+		bool first;
+	};
+
+	void beginValue();
+	void end(char close);
+	int depth() { return baseDepth_ + (int)levels_.size(); }
+
+	std::ostream &os_;
+	SerializeConfig conf_;
+	int baseDepth_;
+	bool afterKey_ = false;
+	std::vector<Level> levels_;
+};
+
+// A value in a Snapshot, read in place.
+// Reading never allocates (except for toValue),
+// and a missing or corrupt value reads as null.
+class SnapshotValue {
+public:
+	SnapshotValue() {}
+
+	Json::ValueType type() const;
+	bool isNull() const { return type() == Json::nullValue; }
+
+	// Numbers which are out of range for the type are clamped to it,
+	// and doubles are truncated toward zero; NaN converts to 0
+	bool asBool() const;
+	Json::Int64 asInt64() const;
+	Json::UInt64 asUInt64() const;
+	double asDouble() const;
+
+	// Strings are NUL terminated, but may contain NULs too;
+	// use getString to get the whole string
+	const char *asCString() const;
+	bool getString(const char **begin, const char **end) const;
+
+	// The number of elements/members of an array/object, 0 for anything else
+	Json::ArrayIndex size() const;
+
+	// An array element, or the value of an object member in key order.
+	// Null if 'index' is out of range.
+	SnapshotValue operator[](Json::ArrayIndex index) const;
+	SnapshotValue operator[](int index) const { return (*this)[(Json::ArrayIndex)index]; }
+
+	// The key of an object member, in key order
+	const char *key(Json::ArrayIndex index) const;
+
+	// An object member, found by a binary search over the keys.
+	// Null if there's no such member.
+	SnapshotValue operator[](const char *key) const;
+	SnapshotValue operator[](const std::string &key) const;
+	SnapshotValue find(const char *begin, const char *end) const;
+	bool isMember(const char *key) const { return (*this)[key].data_ != nullptr; }
+	bool isMember(const std::string &key) const { return (*this)[key].data_ != nullptr; }
+
+	// Copy the value into a Json::Value.
+	// Values nested deeper than writeSnapshot allows, which only
+	// a corrupt snapshot has, are copied as null.
+	Json::Value toValue() const;
+
+private:
+	friend class Snapshot;
+
+	Json::Value toValue(int depth) const;
+
+	SnapshotValue(const unsigned char *data, size_t size, uint32_t offset):
+		data_(data), size_(size), offset_(offset) {}
+
+	bool has(uint64_t n) const { return data_ && offset_ + n <= size_; }
+	uint32_t readU32(size_t at) const;
+	unsigned char tag() const;
+	SnapshotValue child(uint32_t offset) const;
+
+	const unsigned char *data_ = nullptr;
+	size_t size_ = 0;
+	uint32_t offset_ = 0;
+};
+
+// A document in the binary format written by writeSnapshot,
+// which is queried in place without parsing it.
+// Snapshots are meant for caching a parsed document on the machine
+// which wrote it: they use the native byte order,
+// and can't be bigger than 4 GiB.
+//
+// Convert between formats with Json5::parse and writeSnapshot on the way in,
+// and root().toValue() and Json5::serialize on the way out.
+class Snapshot {
+public:
+	Snapshot() {}
+
+	// Read a snapshot which is already in memory.
+	// 'data' must outlive the Snapshot.
+	Snapshot(const void *data, size_t size);
+
+	Snapshot(Snapshot &&other);
+	Snapshot &operator=(Snapshot &&other);
+	~Snapshot();
+
+	// Map a snapshot file into memory.
+	// Only the pages which are actually read are loaded from disk.
+	// Without JSON5CPP_POSIX, the whole file is read into memory instead.
+	bool openFile(const std::string &path, std::string *err = nullptr);
+
+	// Whether the data starts with a valid snapshot header
+	bool valid() const { return data_ != nullptr; }
+
+	SnapshotValue root() const;
+
+private:
+	void close();
+
+	const unsigned char *data_ = nullptr;
+	size_t size_ = 0;
+	void *mapping_ = nullptr;
+	size_t mappingSize_ = 0;
+};
+
+// Write 'v' as a snapshot. Strings, including keys, are only stored once.
+// Fails if the snapshot would be bigger than 4 GiB, if 'v' is nested
+// more than 1000 levels deep, or if writing fails.
+bool writeSnapshot(
+		std::ostream &os, const Json::Value &v, std::string *err = nullptr);
+
 #ifndef JSON5CPP_FWD_ONLY
 
 namespace detail {
@@ -75,11 +817,68 @@ namespace detail {
 struct Location {
 	int line = 1;
 	int ch = 1;
+	size_t offset = 0;
+};
+
+// Input the Reader can pull from, other than an istream or memory
+struct Source {
+	virtual ~Source() = default;
+
+	// Read up to 'size' bytes into 'buf'. Returns 0 at the end of the input.
+	virtual size_t read(unsigned char *buf, size_t size) = 0;
 };
 
 class Reader {
 public:
-	Reader(std::istream &is, ParseConfig conf = {}): is_(is), conf_(conf) {
+	Reader(ParseConfig conf = {}): conf_(conf) {
+		if (conf_.sourceMap) {
+			conf_.recordOffsets = true;
+		}
+	}
+
+	Reader(std::istream &is, ParseConfig conf = {}): Reader(conf) {
+		reset(is);
+	}
+
+	// Start reading a new document,
+	// keeping the scratch buffer and number parser around
+	void reset(std::istream &is) {
+		is_ = &is;
+		source_ = nullptr;
+		data_ = buffer_;
+		index_ = 0;
+		size_ = 0;
+		consumed_ = 0;
+		loc_ = Location();
+		resetSourceMap();
+		fill();
+	}
+
+	// Start reading a new document directly from memory,
+	// without copying it through the buffer.
+	// 'offset' is the offset of 'data' in a bigger document, if it's a part of one.
+	void reset(const char *data, size_t size, size_t offset = 0) {
+		is_ = nullptr;
+		source_ = nullptr;
+		data_ = (const unsigned char *)data;
+		index_ = 0;
+		size_ = size;
+		consumed_ = offset;
+		loc_ = Location();
+		resetSourceMap();
+	}
+
+	// Start reading a new document from a source,
+	// which reads directly into the buffer
+	void reset(Source &source) {
+		is_ = nullptr;
+		source_ = &source;
+		data_ = buffer_;
+		index_ = 0;
+		size_ = 0;
+		consumed_ = 0;
+		loc_ = Location();
+		resetSourceMap();
 		fill();
 	}
 
@@ -92,7 +891,7 @@ public:
 			return EOF;
 		}
 
-		return buffer_[index_ + n];
+		return data_[index_ + n];
 	}
 
 	int get() {
@@ -102,12 +901,39 @@ public:
 		if (ch == '\n') {
 			loc_.ch = 1;
 			loc_.line += 1;
+			if (conf_.sourceMap) {
+				conf_.sourceMap->lines.push_back(offset());
+			}
 		}
 		return ch;
 	}
 
 	Location loc() {
-		return loc_;
+		Location loc = loc_;
+		loc.offset = offset();
+		return loc;
+	}
+
+	// The unread part of the buffer, for scanning many characters at once.
+	// The input may continue past the returned 'size' bytes.
+	const unsigned char *buffered(size_t &size) {
+		if (index_ >= size_) {
+			fill();
+		}
+
+		size = index_ < size_ ? size_ - index_ : 0;
+		return data_ + index_;
+	}
+
+	// Skip 'n' buffered characters, which must not contain any newlines
+	void skip(size_t n) {
+		index_ += n;
+		loc_.ch += n;
+	}
+
+	// The byte offset of the next character
+	size_t offset() {
+		return consumed_ + index_;
 	}
 
 	const ParseConfig &conf() {
@@ -123,36 +949,158 @@ public:
 		return *jsonCharReader_;
 	}
 
+	// A cleared buffer for reading strings, keys and numbers,
+	// reused to avoid allocating for each of them.
+	// The contents are only valid until the next call.
+	std::string &scratch() {
+		scratch_.clear();
+		return scratch_;
+	}
+
+	SourceMap *sourceMap() {
+		return conf_.sourceMap;
+	}
+
+	// The span of the value being parsed, which new spans are children of
+	size_t &openSpan() {
+		return openSpan_;
+	}
+
 private:
+	void resetSourceMap() {
+		openSpan_ = SIZE_MAX;
+		if (conf_.sourceMap) {
+			conf_.sourceMap->spans.clear();
+			conf_.sourceMap->lines.clear();
+			conf_.sourceMap->lines.push_back(consumed_);
+		}
+	}
+
 	void fill() {
-		if (index_ > size_) {
+		if ((!is_ && !source_) || index_ > size_) {
 			return;
 		}
 
 		memmove(buffer_, buffer_ + index_, size_ - index_);
 		size_ -= index_;
+		consumed_ += index_;
 		index_ = 0;
-		size_ += is_.read((char *)buffer_ + size_, sizeof(buffer_) - size_).gcount();
+		if (source_) {
+			size_ += source_->read(buffer_ + size_, sizeof(buffer_) - size_);
+		} else {
+			size_ += is_->read((char *)buffer_ + size_, sizeof(buffer_) - size_).gcount();
+		}
 	}
 
-	std::istream &is_;
+	std::istream *is_ = nullptr;
+	Source *source_ = nullptr;
+	const unsigned char *data_ = nullptr;
 	unsigned char buffer_[128];
 	size_t index_ = 0;
 	size_t size_ = 0;
+	size_t consumed_ = 0;
 	Location loc_;
 	ParseConfig conf_;
+	size_t openSpan_ = SIZE_MAX;
 
 	std::unique_ptr<Json::CharReader> jsonCharReader_;
+	std::string scratch_;
 };
 
+// The dialects the parser is compiled for.
+// The parse and validate functions are templated on the dialect,
+// and Json5::parse picks one based on the ParseConfig,
+// so that the dialect isn't checked over and over for every element.
+struct Json5Dialect {
+	static constexpr bool json5 = true;
+	static constexpr bool newlinesAsCommas = false;
+};
+
+struct Json5NewlinesDialect {
+	static constexpr bool json5 = true;
+	static constexpr bool newlinesAsCommas = true;
+};
+
+struct JsonDialect {
+	static constexpr bool json5 = false;
+	static constexpr bool newlinesAsCommas = false;
+};
+
+template<typename D>
 bool parseValue(Reader &r, Json::Value &v, std::string *err, int depth);
+template<typename D>
+bool validateValue(Reader &r, std::string *err, int depth);
+template<typename D, typename Sink>
+bool validateNumber(Reader &r, std::string *err, Sink &raw);
 
-void serializeValue(
-		std::ostream &os, const Json::Value &v,
-		const SerializeConfig &conf, int depth);
-void serializeStringLiteral(std::ostream &os, const char *ident);
+struct PathToken {
+	std::string key;
+	long long index; // -1 if the token isn't a valid array index
+};
+
+typedef std::vector<std::vector<PathToken>> PathSet;
+
+// The paths from ParseConfig::paths which pass through
+// the value currently being parsed
+struct PathFilter {
+	const PathSet *paths = nullptr;
+	std::vector<size_t> active;
+	size_t level = 0;
+};
+
+// ParseConfig::paths, split into tokens
+struct PathSelection {
+	PathSet paths;
+	PathFilter filter;
+	bool whole = false; // Whether one of the paths selects the whole document
+	bool valid = true;
+};
+
+template<typename D>
+bool parseFilteredChild(
+		Reader &r, Json::Value &v, const std::string *key, Json::ArrayIndex index,
+		std::string *err, int depth, const PathFilter &filter, PathFilter &child);
+
+// A sink for the read* functions which throws everything away,
+// for when we only need to know whether the input is valid
+struct NullSink {
+	template<typename T>
+	NullSink &operator+=(T) {
+		return *this;
+	}
+
+	NullSink &append(const char *, size_t) {
+		return *this;
+	}
+};
+
+// A sink which keeps just enough of an identifier to recognize keywords
+struct KeywordSink {
+	char buf[8];
+	size_t len = 0;
+
+	KeywordSink &operator+=(int ch) {
+		if (len < sizeof(buf)) {
+			buf[len] = ch;
+		}
+		len += 1;
+		return *this;
+	}
+
+	bool operator==(const char *keyword) const {
+		size_t n = strlen(keyword);
+		return len == n && memcmp(buf, keyword, n) == 0;
+	}
+};
+
+inline void error(ParseError *out, Location loc, std::string *err, ErrorCode code) {
+	if (out) {
+		out->code = code;
+		out->offset = loc.offset;
+		out->line = loc.line;
+		out->column = loc.ch;
+	}
 
-inline void error(Location loc, std::string *err, const char *what) {
 	if (!err) {
 		return;
 	}
@@ -161,7 +1109,241 @@ inline void error(Location loc, std::string *err, const char *what) {
 	*err += ':';
 	*err += std::to_string(loc.ch);
 	*err += ": ";
-	*err += what;
+	*err += errorMessage(code);
+}
+
+inline void error(Reader &r, Location loc, std::string *err, ErrorCode code) {
+	error(r.conf().error, loc, err, code);
+}
+
+inline void recordOffsets(Reader &r, Json::Value &v, size_t start) {
+	if (r.conf().recordOffsets) {
+		v.setOffsetStart(start);
+		v.setOffsetLimit(r.offset());
+	}
+}
+
+// Add the span of a value which starts at 'start' to the source map, if there is one,
+// before its children are parsed, so that spans end up in the order values start.
+// Returns the span's index, for endSpan to fill in its limit once the value is parsed.
+inline size_t beginSpan(Reader &r, const Json::Value &v, size_t start) {
+	SourceMap *map = r.sourceMap();
+	if (!map) {
+		return 0;
+	}
+
+	map->spans.push_back(SourceMap::Span{&v, start, start, r.openSpan()});
+	r.openSpan() = map->spans.size() - 1;
+	return r.openSpan();
+}
+
+inline void endSpan(Reader &r, size_t span) {
+	if (SourceMap *map = r.sourceMap()) {
+		map->spans[span].limit = r.offset();
+		r.openSpan() = map->spans[span].parent;
+	}
+}
+
+// Raw numbers are strings with their offsets swapped, so that the start
+// is after the limit, which is how they're told apart from real strings.
+// That keeps their offsets around for reparse, which only compares them.
+inline void storeRawNumber(
+		Reader &r, Json::Value &v, const std::string &text, size_t start) {
+	v = text;
+	v.setOffsetStart(r.offset());
+	v.setOffsetLimit(start);
+}
+
+// Character classes for the lexer, so that classifying a character
+// is one table lookup rather than a chain of comparisons
+enum CharClass {
+	CLASS_SPACE = 1 << 0, // ASCII whitespace
+	CLASS_IDENT = 1 << 1, // Characters which can start an identifier
+	CLASS_DIGIT = 1 << 2,
+	CLASS_HEX = 1 << 3,
+	CLASS_DELIM = 1 << 4, // Characters which end a number or a bare identifier
+	CLASS_NON_ASCII = 1 << 5,
+	CLASS_SPACE_LEAD = 1 << 6, // Lead bytes of multi-byte whitespace
+};
+
+constexpr unsigned char classifyChar(int ch) {
+	return (unsigned char)(
+		(
+			ch == '\t' || ch == '\n' || ch == '\v' ||
+			ch == '\f' || ch == '\r' || ch == ' ' ? CLASS_SPACE : 0) |
+		(
+			(ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+			ch == '$' || ch == '_' || ch == '\\' ? CLASS_IDENT : 0) |
+		(ch >= '0' && ch <= '9' ? CLASS_DIGIT : 0) |
+		(
+			(ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f') ||
+			(ch >= 'A' && ch <= 'F') ? CLASS_HEX : 0) |
+		(
+			ch == ',' || ch == ':' || ch == '/' || ch == '{' || ch == '}' ||
+			ch == '[' || ch == ']' || ch == '"' || ch == '\'' ? CLASS_DELIM : 0) |
+		(ch >= 0x80 ? CLASS_NON_ASCII : 0) |
+		(
+			ch == 0xc2 || ch == 0xe1 || ch == 0xe2 ||
+			ch == 0xe3 || ch == 0xef ? CLASS_SPACE_LEAD : 0));
+}
+
+#define JSON5CPP_CLASSIFY_4(n) \
+	classifyChar(n), classifyChar(n + 1), classifyChar(n + 2), classifyChar(n + 3)
+#define JSON5CPP_CLASSIFY_16(n) \
+	JSON5CPP_CLASSIFY_4(n), JSON5CPP_CLASSIFY_4(n + 4), \
+	JSON5CPP_CLASSIFY_4(n + 8), JSON5CPP_CLASSIFY_4(n + 12)
+#define JSON5CPP_CLASSIFY_64(n) \
+	JSON5CPP_CLASSIFY_16(n), JSON5CPP_CLASSIFY_16(n + 16), \
+	JSON5CPP_CLASSIFY_16(n + 32), JSON5CPP_CLASSIFY_16(n + 48)
+
+// A template, so that the table can be defined in the header
+// without violating the one definition rule
+template<typename T = void>
+struct CharClasses {
+	static constexpr unsigned char table[256] = {
+		JSON5CPP_CLASSIFY_64(0), JSON5CPP_CLASSIFY_64(64),
+		JSON5CPP_CLASSIFY_64(128), JSON5CPP_CLASSIFY_64(192),
+	};
+};
+
+template<typename T>
+constexpr unsigned char CharClasses<T>::table[256];
+
+#undef JSON5CPP_CLASSIFY_4
+#undef JSON5CPP_CLASSIFY_16
+#undef JSON5CPP_CLASSIFY_64
+
+inline int charClass(int ch) {
+	return ch == EOF ? 0 : CharClasses<>::table[ch];
+}
+
+// Returns the length of the UTF-8 sequence starting with the bytes a, b, c, d,
+// or 0 if it's invalid. Missing bytes should be EOF.
+// https://datatracker.ietf.org/doc/html/rfc3629#section-4
+inline int utf8SequenceLength(int a, int b, int c, int d) {
+	auto cont = [](int ch) { return ch >= 0x80 && ch <= 0xbf; };
+	if (a < 0x80) {
+		return 1;
+	} else if (a >= 0xc2 && a <= 0xdf) {
+		return cont(b) ? 2 : 0;
+	} else if (a == 0xe0) {
+		return b >= 0xa0 && b <= 0xbf && cont(c) ? 3 : 0;
+	} else if (a == 0xed) {
+		// Reject surrogates
+		return b >= 0x80 && b <= 0x9f && cont(c) ? 3 : 0;
+	} else if (a >= 0xe1 && a <= 0xef) {
+		return cont(b) && cont(c) ? 3 : 0;
+	} else if (a == 0xf0) {
+		return b >= 0x90 && b <= 0xbf && cont(c) && cont(d) ? 4 : 0;
+	} else if (a >= 0xf1 && a <= 0xf3) {
+		return cont(b) && cont(c) && cont(d) ? 4 : 0;
+	} else if (a == 0xf4) {
+		return b >= 0x80 && b <= 0x8f && cont(c) && cont(d) ? 4 : 0;
+	} else {
+		return 0;
+	}
+}
+
+// The number of bytes at the end of data[0, i) which start a UTF-8 sequence
+// that continues past 'i'. Everything before 'i' must be valid UTF-8 otherwise.
+inline size_t utf8IncompleteLength(const unsigned char *data, size_t i) {
+	if (i >= 1 && data[i - 1] >= 0xc0) {
+		return 1;
+	} else if (i >= 2 && data[i - 2] >= 0xe0) {
+		return 2;
+	} else if (i >= 3 && data[i - 3] >= 0xf0) {
+		return 3;
+	}
+
+	return 0;
+}
+
+#if defined(__SSSE3__)
+// Check 16 bytes of UTF-8 at once, using the lookup tables from
+// "Validating UTF-8 In Less Than One Instruction Per Byte" (Keiser and Lemire):
+// every pair of adjacent bytes is classified by the high and low nibble of the first
+// and the high nibble of the second, and the three classes have a bit in common
+// for exactly the invalid pairs. 'prev' is the 16 bytes before 'chunk'.
+// A sequence which is cut short at the end of 'chunk' is only caught with the next chunk.
+inline bool utf8ChunkValid(__m128i chunk, __m128i prev) {
+	const char tooShort = 1 << 0; // A lead byte not followed by a continuation
+	const char tooLong = 1 << 1; // A continuation after ASCII
+	const char overlong3 = 1 << 2;
+	const char tooLarge = 1 << 3; // Above U+10FFFF
+	const char surrogate = 1 << 4;
+	const char overlong2 = 1 << 5;
+	const char tooLarge1000 = 1 << 6;
+	const char overlong4 = 1 << 6;
+	const char twoConts = (char)(1 << 7); // Two continuations, only valid in 3 and 4 byte sequences
+	const char carry = tooShort | tooLong | twoConts;
+
+	const __m128i nibble = _mm_set1_epi8(0x0f);
+	__m128i prev1 = _mm_alignr_epi8(chunk, prev, 15);
+	__m128i byte1High = _mm_shuffle_epi8(_mm_setr_epi8(
+		tooLong, tooLong, tooLong, tooLong, tooLong, tooLong, tooLong, tooLong,
+		twoConts, twoConts, twoConts, twoConts,
+		tooShort | overlong2,
+		tooShort,
+		tooShort | overlong3 | surrogate,
+		tooShort | tooLarge | tooLarge1000 | overlong4),
+		_mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+	__m128i byte1Low = _mm_shuffle_epi8(_mm_setr_epi8(
+		carry | overlong3 | overlong2 | overlong4,
+		carry | overlong2,
+		carry,
+		carry,
+		carry | tooLarge,
+		carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000 | surrogate,
+		carry | tooLarge | tooLarge1000,
+		carry | tooLarge | tooLarge1000),
+		_mm_and_si128(prev1, nibble));
+	__m128i byte2High = _mm_shuffle_epi8(_mm_setr_epi8(
+		tooShort, tooShort, tooShort, tooShort, tooShort, tooShort, tooShort, tooShort,
+		tooLong | overlong2 | twoConts | overlong3 | tooLarge1000 | overlong4,
+		tooLong | overlong2 | twoConts | overlong3 | tooLarge,
+		tooLong | overlong2 | twoConts | surrogate | tooLarge,
+		tooLong | overlong2 | twoConts | surrogate | tooLarge,
+		tooShort, tooShort, tooShort, tooShort),
+		_mm_and_si128(_mm_srli_epi16(chunk, 4), nibble));
+	__m128i classes = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+	// Two continuations in a row are fine exactly where they're the third or fourth byte
+	// of a sequence, that is where the byte two back is a 3 or 4 byte lead,
+	// or the byte three back is a 4 byte lead
+	__m128i third = _mm_subs_epu8(_mm_alignr_epi8(chunk, prev, 14), _mm_set1_epi8((char)(0xe0 - 0x80)));
+	__m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(chunk, prev, 13), _mm_set1_epi8((char)(0xf0 - 0x80)));
+	__m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+	__m128i errors = _mm_xor_si128(must23, classes);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(errors, _mm_setzero_si128())) == 0xffff;
+}
+#endif
+
+// Read the rest of a UTF-8 sequence whose first byte 'ch' has just been read
+template<typename Sink>
+inline bool readUtf8Sequence(Reader &r, int ch, Sink &str, std::string *err) {
+	int len = utf8SequenceLength(ch, r.peek(0), r.peek(1), r.peek(2));
+	if (len == 0) {
+		Location loc = r.loc();
+		loc.ch -= 1;
+		loc.offset -= 1;
+		error(r, loc, err, ERROR_INVALID_UTF8);
+		return false;
+	}
+
+	str += ch;
+	while (--len) {
+		str += r.get();
+	}
+
+	return true;
 }
 
 inline bool isUtf8LineTerminator3B(int a, int b, int c) {
@@ -169,20 +1351,11 @@ inline bool isUtf8LineTerminator3B(int a, int b, int c) {
 	return a == 0xe2 && b == 0x80 && (c == 0xa8 || c == 0xa9);
 }
 
-inline bool isUtf8Whitespace1B(int ch) {
-	return ch == '\t' || ch == '\n' || ch == '\v' ||
-		ch == '\f' || ch == '\r' || ch == ' ';
-}
-
 inline bool isUtf8Whitespace2B(int a, int b) {
 	return a == 0xc2 && b == 0xa0; // Non-breaking space
 }
 
 inline bool isUtf8Whitespace3B(int a, int b, int c) {
-	if (a < 128) {
-		return false;
-	}
-
 	return isUtf8LineTerminator3B(a, b, c) ||
 		(a == 0xef && b == 0xbb && c == 0xbf) || // BOM
 		(a == 0xe1 && b == 0x9a && c == 0x80) || // Ogham Space Mark
@@ -192,6 +1365,21 @@ inline bool isUtf8Whitespace3B(int a, int b, int c) {
 		(a == 0xe3 && b == 0x80 && c == 0x80); // Ideographic Space
 }
 
+// Returns the length of the multi-byte whitespace character at the reader's position,
+// which starts with 'ch', or 0 if it's not whitespace.
+// Only a few lead bytes can start whitespace, so most characters need no more peeking.
+inline int utf8WhitespaceLength(Reader &r, int ch) {
+	if (!(charClass(ch) & CLASS_SPACE_LEAD)) {
+		return 0;
+	} else if (isUtf8Whitespace2B(ch, r.peek(1))) {
+		return 2;
+	} else if (isUtf8Whitespace3B(ch, r.peek(1), r.peek(2))) {
+		return 3;
+	} else {
+		return 0;
+	}
+}
+
 // Skip past https://262.ecma-international.org/5.1/#sec-7.3 LineTerminator
 inline void skipPastLineTerminator(Reader &r) {
 	while (true) {
@@ -210,26 +1398,35 @@ inline void skipPastLineTerminator(Reader &r) {
 // Skip https://spec.json5.org/#white-space White Space
 // and https://spec.json5.org/#comments Comments
 // Returns true if a newline was skipped.
+template<typename D>
 inline bool skipWhitespace(Reader &r) {
 	bool newline = false;
 	// Ignore Unicode Space Separator characters,
 	// Json5Cpp doesn't have a Unicode database
 	while (true) {
 		int ch = r.peek();
+		int cls = charClass(ch);
+		int len;
+		if (!D::json5) {
+			// JSON has just four whitespace characters, and no comments
+			if (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
+				newline = newline || ch == '\n';
+				r.get();
+				continue;
+			}
+
+			return newline;
+		}
+
 		if (ch == EOF) {
 			return newline;
-		} else if (ch == '\n') {
-			newline = true;
-			r.get();
-		} else if (isUtf8Whitespace1B(ch)) {
-			r.get();
-		} else if (isUtf8Whitespace2B(ch, r.peek(1))) {
-			r.get();
-			r.get();
-		} else if (isUtf8Whitespace3B(ch, r.peek(1), r.peek(2))) {
-			r.get();
-			r.get();
+		} else if (cls & CLASS_SPACE) {
+			newline = newline || ch == '\n';
 			r.get();
+		} else if ((len = utf8WhitespaceLength(r, ch)) > 0) {
+			while (len--) {
+				r.get();
+			}
 		} else if (ch == '/' && r.peek(1) == '/') {
 			r.get();
 			r.get();
@@ -249,42 +1446,46 @@ inline bool skipWhitespace(Reader &r) {
 	}
 }
 
-// https://262.ecma-international.org/5.1/#sec-7.6 IdentifierStart
-inline bool isIdentStartChar1B(int ch) {
-	return
-		(ch >= 'a' && ch <= 'z') ||
-		(ch >= 'A' && ch <= 'Z') ||
-		ch == '$' || ch == '_' || ch == '\\';
-}
-
 // https://262.ecma-international.org/5.1/#sec-7.6 IdentifierPart
-inline bool isIdentPartChar(int a, int b, int c) {
+inline bool isIdentPartChar(Reader &r, int ch) {
 	// Json5Cpp doesn't have a Unicode database, so let's just assume non-whitespace
 	// non-ASCII characters are valid identifier characters
-	return isIdentStartChar1B(a) ||
-		(a >= 128 && !isUtf8Whitespace2B(a, b) && !isUtf8Whitespace3B(a, b, c)) ||
-		(a >= '0' && a <= '9');
+	int cls = charClass(ch);
+	return (cls & (CLASS_IDENT | CLASS_DIGIT)) ||
+		((cls & CLASS_NON_ASCII) && utf8WhitespaceLength(r, ch) == 0);
 }
 
 // https://262.ecma-international.org/5.1/#sec-7.6 IdentifierName
-inline bool readIdentifier(Reader &r, std::string &str, std::string *err) {
+template<typename Sink>
+inline bool readIdentifier(Reader &r, Sink &str, std::string *err) {
 	// If we're here, we've already skipped whitespace,
 	// so we can assume that characters >=128 are valid identifier characters
+	// https://262.ecma-international.org/5.1/#sec-7.6 IdentifierStart
 	int ch = r.peek();
-	if (ch < 128 && !isIdentStartChar1B(ch)) {
-		error(r.loc(), err, "Invalid start character in identifier");
+	if (!(charClass(ch) & (CLASS_IDENT | CLASS_NON_ASCII))) {
+		error(r, r.loc(), err, ERROR_INVALID_IDENTIFIER_START);
 		return false;
 	}
 
-	str += r.get();
-	while (isIdentPartChar(r.peek(0), r.peek(1), r.peek(2))) {
-		str += r.get();
-	}
+	bool validate = r.conf().validateUtf8;
+	do {
+		ch = r.get();
+		if (ch >= 128 && validate) {
+			if (!readUtf8Sequence(r, ch, str, err)) {
+				return false;
+			}
+		} else {
+			str += ch;
+		}
+	} while (isIdentPartChar(r, r.peek()));
 
 	return true;
 }
 
-inline void serializeIdentifier(
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void serializeIdentifier(
 		std::ostream &os, const char *ident,
 		const SerializeConfig &conf) {
 	if (!conf.bareKeys || *ident == '\0') {
@@ -317,21 +1518,18 @@ inline void serializeIdentifier(
 }
 
 inline int hexChar(int ch) {
-	if (ch == EOF) {
+	if (!(charClass(ch) & CLASS_HEX)) {
 		return EOF;
-	} else if (ch >= '0' && ch <= '9') {
+	} else if (ch <= '9') {
 		return ch - '0';
-	} else if (ch >= 'a' && ch <= 'f') {
-		return ch - 'a' + 10;
-	} else if (ch >= 'A' && ch <= 'Z') {
-		return ch - 'A' + 10;
 	} else {
-		return EOF;
+		return (ch | 0x20) - 'a' + 10;
 	}
 }
 
 // Write a code point (up to 16 bit) as UTF-8
-inline void writeUtf8(unsigned int num, std::string &str) {
+template<typename Sink>
+inline void writeUtf8(unsigned int num, Sink &str) {
 	if (num >= 0x10000u) {
 		str += 0xf0u | ((num & 0x1c0000u) >> 18u);
 		str += 0x80u | ((num & 0x03f000u) >> 12u);
@@ -356,7 +1554,7 @@ inline bool read4Hex(Reader &r, unsigned int &u, std::string *err) {
 	int c = hexChar(r.get());
 	int d = hexChar(r.get());
 	if (a == EOF || b == EOF || c == EOF || d == EOF) {
-		error(loc, err, "Invalid hex sequence");
+		error(r, loc, err, ERROR_INVALID_HEX);
 		return false;
 	}
 
@@ -368,7 +1566,8 @@ inline bool read4Hex(Reader &r, unsigned int &u, std::string *err) {
 	return true;
 }
 
-inline bool readUnicodeEscape(Reader &r, std::string &str, std::string *err) {
+template<typename Sink>
+inline bool readUnicodeEscape(Reader &r, Sink &str, std::string *err) {
 	// Assume we have already read the first '\' and 'u'
 
 	unsigned int u1;
@@ -380,13 +1579,13 @@ inline bool readUnicodeEscape(Reader &r, std::string &str, std::string *err) {
 	if (u1 >= 0xd800u && u1 <= 0xdbffu) {
 		// First character was a high surrogate, read the low surrogate
 		if (r.peek() != '\\') {
-			error(loc, err, "Expected trailing surrogate");
+			error(r, loc, err, ERROR_EXPECTED_TRAILING_SURROGATE);
 			return false;
 		}
 		r.get();
 
 		if (r.peek() != 'u') {
-			error(loc, err, "Expected trailing surrogate");
+			error(r, loc, err, ERROR_EXPECTED_TRAILING_SURROGATE);
 			return false;
 		}
 		r.get();
@@ -398,7 +1597,7 @@ inline bool readUnicodeEscape(Reader &r, std::string &str, std::string *err) {
 
 		if (!(u2 >= 0xdc00u && u2 <= 0xdfffu)) {
 			// Don't pair the high surrogate with a non-low-surrogate
-			error(loc, err, "Expected trailing surrogate");
+			error(r, loc, err, ERROR_EXPECTED_TRAILING_SURROGATE);
 			return false;
 		}
 
@@ -406,7 +1605,7 @@ inline bool readUnicodeEscape(Reader &r, std::string &str, std::string *err) {
 		return true;
 	} else if (u1 >= 0xdc00u && u1 <= 0xdfffu) {
 		// Don't allow unpaired surrogates
-		error(loc, err, "Invalid trailing surrogate");
+		error(r, loc, err, ERROR_INVALID_TRAILING_SURROGATE);
 		return false;
 	} else {
 		writeUtf8(u1, str);
@@ -414,21 +1613,157 @@ inline bool readUnicodeEscape(Reader &r, std::string &str, std::string *err) {
 	}
 }
 
+// Read the run of buffered string characters which need no special handling,
+// up to the next quote, backslash, line break
+// (or any control character in JSON) or the end of the buffer.
+// This is where most of the time is spent in string heavy documents,
+// so ASCII is checked 16 bytes at a time where the CPU lets us.
+// With validateUtf8, the vector loop validates non-ASCII text too where SSSE3 is available,
+// and hands off to the scalar loop at the start of a sequence when it stops.
+template<typename D, typename Sink>
+inline bool readStringRun(Reader &r, int startChar, Sink &str, std::string *err) {
+	bool validate = r.conf().validateUtf8;
+	size_t size;
+	const unsigned char *data = r.buffered(size);
+	size_t i = 0;
+	while (i < size) {
+#if defined(__SSE2__)
+		__m128i quote = _mm_set1_epi8((char)startChar);
+		__m128i backslash = _mm_set1_epi8('\\');
+		__m128i lf = _mm_set1_epi8('\n');
+		__m128i cr = _mm_set1_epi8('\r');
+		__m128i lastControl = _mm_set1_epi8(0x1f);
+#if defined(__SSSE3__)
+		// 'i' is at the start of a sequence here, so it's as if ASCII came before
+		__m128i prev = _mm_setzero_si128();
+		int prevHigh = 0;
+#endif
+		while (i + 16 <= size) {
+			__m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+			__m128i control = D::json5 ?
+				_mm_or_si128(_mm_cmpeq_epi8(chunk, lf), _mm_cmpeq_epi8(chunk, cr)) :
+				_mm_cmpeq_epi8(_mm_min_epu8(chunk, lastControl), chunk);
+			__m128i special = _mm_or_si128(
+					_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+					control);
+			int stop = _mm_movemask_epi8(special);
+			int high = validate ? _mm_movemask_epi8(chunk) : 0; // Non-ASCII bytes
+#if defined(__SSSE3__)
+			if (!stop && (high | prevHigh) && !utf8ChunkValid(chunk, prev)) {
+				stop = 1; // The scalar loop finds out exactly where
+			}
+
+			if (stop) {
+				// Bytes before the stop which still need validating are left to the scalar loop
+				int first = __builtin_ctz(stop);
+				if (!(high & ((1 << first) - 1)) && !(validate && utf8IncompleteLength(data, i))) {
+					i += first;
+				}
+				break;
+			}
+
+			prev = chunk;
+			prevHigh = high;
+#else
+			stop |= high;
+			if (stop) {
+				i += __builtin_ctz(stop);
+				break;
+			}
+#endif
+			i += 16;
+		}
+
+#if defined(__SSSE3__)
+		// Back up to the start of a sequence cut short by the end of the vector loop
+		if (validate) {
+			i -= utf8IncompleteLength(data, i);
+		}
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+		uint8x16_t quote = vdupq_n_u8((uint8_t)startChar);
+		uint8x16_t backslash = vdupq_n_u8('\\');
+		uint8x16_t lf = vdupq_n_u8('\n');
+		uint8x16_t cr = vdupq_n_u8('\r');
+		uint8x16_t lastControl = vdupq_n_u8(0x1f);
+		uint8x16_t high = vdupq_n_u8(validate ? 0x80 : 0);
+		while (i + 16 <= size) {
+			uint8x16_t chunk = vld1q_u8(data + i);
+			uint8x16_t control = D::json5 ?
+				vorrq_u8(vceqq_u8(chunk, lf), vceqq_u8(chunk, cr)) :
+				vcleq_u8(chunk, lastControl);
+			uint8x16_t special = vorrq_u8(
+					vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)),
+					control);
+			special = vorrq_u8(special, vandq_u8(chunk, high));
+			if (vmaxvq_u8(special) != 0) {
+				// Let the scalar loop find the exact byte
+				break;
+			}
+			i += 16;
+		}
+#endif
+
+		if (i >= size) {
+			break;
+		}
+
+		int ch = data[i];
+		if (
+				ch == startChar || ch == '\\' || ch == '\n' || ch == '\r' ||
+				(!D::json5 && ch < 0x20)) {
+			break;
+		} else if (ch < 0x80 || !validate) {
+			i += 1;
+			continue;
+		}
+
+		// Sequences which might continue past the buffer are left to the caller
+		if (size - i < 4) {
+			break;
+		}
+
+		int len = utf8SequenceLength(ch, data[i + 1], data[i + 2], data[i + 3]);
+		if (len == 0) {
+			Location loc = r.loc();
+			loc.ch += i;
+			loc.offset += i;
+			error(r, loc, err, ERROR_INVALID_UTF8);
+			return false;
+		}
+		i += len;
+	}
+
+	str.append((const char *)data, i);
+	r.skip(i);
+	return true;
+}
+
 // https://spec.json5.org/#strings JSON5String
-inline bool readStringLiteral(Reader &r, std::string &str, std::string *err) {
+template<typename D, typename Sink>
+inline bool readStringLiteral(Reader &r, Sink &str, std::string *err) {
 	int startChar = r.get(); // '"' or "'"
 
 	while (true) {
+		if (!readStringRun<D>(r, startChar, str, err)) {
+			return false;
+		}
+
 		int ch = r.get();
 		if (ch == EOF) {
-			error(r.loc(), err, "Unexpected EOF");
+			error(r, r.loc(), err, ERROR_UNEXPECTED_EOF);
 			return false;
 		} else if (ch == startChar) {
 			return true;
 		} else if (ch == '\\') {
 			ch = r.get();
 			if (ch == EOF) {
-				error(r.loc(), err, "Unexpected EOF");
+				error(r, r.loc(), err, ERROR_UNEXPECTED_EOF);
+				return false;
+			} else if (!D::json5 && !(
+					ch == '"' || ch == '\\' || ch == '/' || ch == 'b' ||
+					ch == 'f' || ch == 'n' || ch == 'r' || ch == 't' || ch == 'u')) {
+				error(r, r.loc(), err, ERROR_INVALID_ESCAPE);
 				return false;
 			} else if (ch == 'b') {
 				str += '\b';
@@ -459,12 +1794,14 @@ inline bool readStringLiteral(Reader &r, std::string &str, std::string *err) {
 				int a = hexChar(r.get());
 				int b = hexChar(r.get());
 				if (a == EOF || b == EOF) {
-					error(loc, err, "Invalid hex sequence");
+					error(r, loc, err, ERROR_INVALID_HEX);
 					return false;
 				}
-				str += (a << 4) | b;
+				writeUtf8((a << 4) | b, str);
 			} else if (ch == 'u') {
-				readUnicodeEscape(r, str, err);
+				if (!readUnicodeEscape(r, str, err)) {
+					return false;
+				}
 			} else if (ch == '\n' || ch == '\r') {
 				// Ignore line separator and paragraph separator, because again,
 				// I don't wanna deal with parsing UTF-8
@@ -472,6 +1809,10 @@ inline bool readStringLiteral(Reader &r, std::string &str, std::string *err) {
 				if (ch == '\r' && r.peek() == '\n') {
 					str += r.get();
 				}
+			} else if (ch >= 0x80 && r.conf().validateUtf8) {
+				if (!readUtf8Sequence(r, ch, str, err)) {
+					return false;
+				}
 			} else {
 				// Yeah, all other sequences match the NonEscapeCharacter case,
 				// so you may escape any character.
@@ -481,38 +1822,76 @@ inline bool readStringLiteral(Reader &r, std::string &str, std::string *err) {
 		} else if (ch == '\n' || ch == '\r') {
 			// This is *not* ignoring the spec, line separator and paragraph separator
 			// are explicitly allowed in JSON5 strings!
-			error(r.loc(), err, "Unescaped line terminator in string literal");
+			error(r, r.loc(), err, ERROR_UNESCAPED_LINE_TERMINATOR);
+			return false;
+		} else if (!D::json5 && ch < 0x20) {
+			error(r, r.loc(), err, ERROR_UNESCAPED_CONTROL_CHARACTER);
 			return false;
+		} else if (ch >= 0x80 && r.conf().validateUtf8) {
+			if (!readUtf8Sequence(r, ch, str, err)) {
+				return false;
+			}
 		} else {
 			str += ch;
 		}
 	}
 }
 
-inline void serializeStringLiteral(std::ostream &os, const char *ident) {
+// Skip past one value, without building any Json::Value.
+// Skipped values are validated just like the rest of the document,
+// in the same dialect and with the same errors, so selecting paths never changes
+// whether a document is accepted. Validation doesn't decode strings into anything,
+// convert numbers or allocate, so it's as fast as a bare structural scan.
+template<typename D>
+inline bool skipValue(Reader &r, std::string *err, int depth) {
+	return validateValue<D>(r, err, depth);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void serializeStringLiteral(std::ostream &os, const char *ident) {
 	os << '"';
-	for (char ch; (ch = *ident); ++ident) {
+
+	// Write the characters which don't need escaping in runs
+	const char *run = ident;
+	for (; *ident; ++ident) {
+		unsigned char ch = *ident;
+		const char *escape;
+		char buf[8];
 		if (ch == '"') {
-			os << "\\\"";
+			escape = "\\\"";
+		} else if (ch == '\\') {
+			escape = "\\\\";
 		} else if (ch == '\t') {
-			os << "\\t";
+			escape = "\\t";
 		} else if (ch == '\r') {
-			os << "\\r";
+			escape = "\\r";
 		} else if (ch == '\n') {
-			os << "\\n";
+			escape = "\\n";
+		} else if (ch < 0x20) {
+			snprintf(buf, sizeof(buf), "\\u%04x", ch);
+			escape = buf;
 		} else {
-			os << ch;
+			continue;
 		}
+
+		os.write(run, ident - run);
+		os << escape;
+		run = ident + 1;
 	}
+
+	os.write(run, ident - run);
 	os << '"';
 }
 
 // https://spec.json5.org/#numbers JSON5Number
+template<typename D>
 inline bool parseNumber(Reader &r, Json::Value &v, std::string *err) {
 	// Parsing floats accurately is hard.
 	// Instead, let's create a JSON string, then use jsoncpp to parse it.
 	Location loc = r.loc();
-	std::string str;
+	std::string &str = r.scratch();
 
 	bool negative = false;
 	int ch = r.peek();
@@ -526,6 +1905,11 @@ inline bool parseNumber(Reader &r, Json::Value &v, std::string *err) {
 		ch = r.peek();
 	}
 
+	if (!D::json5 && !(ch >= '0' && ch <= '9')) {
+		error(r, loc, err, ERROR_INVALID_NUMBER);
+		return false;
+	}
+
 	if (ch == 'I' || ch == 'N') {
 		str.clear();
 		readIdentifier(r, str, err);
@@ -541,7 +1925,7 @@ inline bool parseNumber(Reader &r, Json::Value &v, std::string *err) {
 			v = std::numeric_limits<double>::quiet_NaN();
 			return true;
 		} else {
-			error(loc, err, "Invalid number");
+			error(r, loc, err, ERROR_INVALID_NUMBER);
 			return false;
 		}
 	} else if (ch == '.') {
@@ -551,12 +1935,16 @@ inline bool parseNumber(Reader &r, Json::Value &v, std::string *err) {
 		str += '0';
 		r.get();
 		ch = r.peek();
-		if (ch == 'x' || ch == 'X') {
+		if (!D::json5 && ch >= '0' && ch <= '9') {
+			// JSON doesn't allow leading zeros
+			error(r, loc, err, ERROR_INVALID_NUMBER);
+			return false;
+		} else if (D::json5 && (ch == 'x' || ch == 'X')) {
 			r.get();
 			Json::UInt64 number = 0;
 			int digit = hexChar(r.peek());
 			if (digit == EOF) {
-				error(r.loc(), err, "Unexpected EOF");
+				error(r, r.loc(), err, ERROR_UNEXPECTED_EOF);
 				return false;
 			}
 			number += digit;
@@ -593,6 +1981,19 @@ inline bool parseNumber(Reader &r, Json::Value &v, std::string *err) {
 		ch = r.peek();
 	}
 
+	// Integers which are sure to fit in an Int64 don't need jsoncpp.
+	// This is what jsoncpp would have given us, just a lot cheaper.
+	size_t digits = str.size() - (negative ? 1 : 0);
+	if (ch != '.' && ch != 'e' && ch != 'E' && digits > 0 && digits <= 18) {
+		Json::Int64 number = 0;
+		for (size_t i = str.size() - digits; i < str.size(); ++i) {
+			number = number * 10 + (str[i] - '0');
+		}
+
+		v = negative ? -number : number;
+		return true;
+	}
+
 	// Potentially trailing dot
 	if (ch == '.') {
 		str += '.';
@@ -600,6 +2001,11 @@ inline bool parseNumber(Reader &r, Json::Value &v, std::string *err) {
 		ch = r.peek();
 		// JSON doesn't support trailing dots
 		if (!(ch >= '0' && ch <= '9')) {
+			if (!D::json5) {
+				error(r, loc, err, ERROR_INVALID_NUMBER);
+				return false;
+			}
+
 			str += '0';
 		}
 	}
@@ -631,14 +2037,17 @@ inline bool parseNumber(Reader &r, Json::Value &v, std::string *err) {
 
 	if (!r.jsonCharReader().parse(
 			str.c_str(), str.c_str() + str.size(), &v, nullptr)) {
-		error(loc, err, "Invalid number");
+		error(r, loc, err, ERROR_INVALID_NUMBER);
 		return false;
 	}
 
 	return true;
 }
 
-inline void serializeNewLine(
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void serializeNewLine(
 		std::ostream &os, const SerializeConfig &conf, int depth) {
 	if (conf.indent == nullptr) {
 		return;
@@ -651,75 +2060,164 @@ inline void serializeNewLine(
 	}
 }
 
-// https://spec.json5.org/#prod-JSON5Object JSON5Object
-inline bool parseObject(Reader &r, Json::Value &v, std::string *err, int depth) {
-	r.get(); // '{'
+// Skip whitespace and the ',' (or newline) between object/array elements.
+// Returns 1 if another element follows, 0 if the closing bracket was consumed,
+// or -1 on error.
+template<typename D>
+inline int skipSeparator(Reader &r, int close, bool &first, std::string *err) {
+	bool newline = skipWhitespace<D>(r);
+	bool comma = false;
 
-	v = Json::objectValue;
-	while (true) {
-		bool newline = skipWhitespace(r);
-		bool comma = false;
+	int ch = r.peek();
+	if (ch == EOF) {
+		error(r, r.loc(), err, ERROR_UNEXPECTED_EOF);
+		return -1;
+	} else if (ch == ',') {
+		if (first) {
+			error(r, r.loc(), err, close == '}' ? ERROR_EXPECTED_KEY_OR_BRACE : ERROR_EXPECTED_VALUE_OR_BRACKET);
+			return -1;
+		}
 
-		int ch = r.peek();
+		r.get();
+		skipWhitespace<D>(r);
+		ch = r.peek();
 		if (ch == EOF) {
-			error(r.loc(), err, "Unexpected EOF");
-			return false;
-		} else if (ch == ',') {
-			r.get();
-			skipWhitespace(r);
-			ch = r.peek();
-			if (ch == EOF) {
-				error(r.loc(), err, "Unexpected EOF");
-				return false;
-			}
+			error(r, r.loc(), err, ERROR_UNEXPECTED_EOF);
+			return -1;
+		}
+
+		comma = true;
+	}
 
-			comma = true;
+	if (ch == close) {
+		if (!D::json5 && comma) {
+			// No trailing commas in JSON
+			error(r, r.loc(), err, close == '}' ? ERROR_EXPECTED_KEY : ERROR_EXPECTED_VALUE);
+			return -1;
 		}
 
-		if (ch == '}') {
-			r.get();
-			return true;
+		r.get();
+		return 0;
+	}
+
+	if (first) {
+		first = false;
+	} else if (D::newlinesAsCommas) {
+		if (!comma && !newline) {
+			error(r, r.loc(), err, close == '}' ?
+				ERROR_EXPECTED_COMMA_NEWLINE_OR_BRACE : ERROR_EXPECTED_COMMA_NEWLINE_OR_BRACKET);
+			return -1;
 		}
+	} else if (!comma) {
+		error(r, r.loc(), err, close == '}' ? ERROR_EXPECTED_COMMA_OR_BRACE : ERROR_EXPECTED_COMMA_OR_BRACKET);
+		return -1;
+	}
 
-		if (r.conf().newlinesAsCommas) {
-			if (!comma && !newline) {
-				error(r.loc(), err, "Expected ',', newline or '}'");
-				return false;
+	return 1;
+}
+
+// The member of 'v' which the value of 'key' is parsed into.
+// With a source map, a duplicate key replaces the earlier value,
+// so the spans of it and its children (which follow it) get a null 'value',
+// rather than pointing at destroyed values. They're kept rather than removed,
+// since the spans of values which are still being parsed can come after them.
+// An object which is merged keeps its earlier children, and their spans.
+template<typename D>
+inline Json::Value &memberForKey(Reader &r, Json::Value &v, const std::string &key) {
+	SourceMap *map = r.sourceMap();
+	if (!map) {
+		return v[key];
+	}
+
+	Json::ArrayIndex size = v.size();
+	Json::Value &member = v[key];
+	if (v.size() != size) {
+		return member;
+	}
+
+	skipWhitespace<D>(r);
+	if (r.conf().merge && member.isObject() && r.peek() == '{') {
+		return member;
+	}
+
+	std::vector<SourceMap::Span> &spans = map->spans;
+	for (size_t i = spans.size(); i-- > 0;) {
+		if (spans[i].value == &member) {
+			size_t limit = spans[i].limit;
+			for (size_t j = i; j < spans.size() && spans[j].start < limit; ++j) {
+				spans[j].value = nullptr;
 			}
-		} else if (!comma) {
-			error(r.loc(), err, "Expected ',' or '}'");
-			return false;
+			break;
+		}
+	}
+
+	return member;
+}
+
+// https://spec.json5.org/#prod-JSON5Object JSON5Object
+template<typename D>
+inline bool parseObject(
+		Reader &r, Json::Value &v, std::string *err, int depth,
+		const PathFilter *filter = nullptr) {
+	r.get(); // '{'
+
+	// When merging, the members are parsed onto the existing ones
+	if (!(r.conf().merge && v.isObject())) {
+		v = Json::objectValue;
+	}
+
+	PathFilter child;
+	bool first = true;
+	while (true) {
+		int next = skipSeparator<D>(r, '}', first, err);
+		if (next <= 0) {
+			return next == 0;
 		}
 
-		std::string key;
-		if (ch == '"' || ch == '\'') {
-			if (!readStringLiteral(r, key, err)) {
+		int ch = r.peek();
+		std::string &key = r.scratch();
+		if (ch == '"' || (D::json5 && ch == '\'')) {
+			if (!readStringLiteral<D>(r, key, err)) {
 				return false;
 			}
+		} else if (!D::json5) {
+			error(r, r.loc(), err, ERROR_EXPECTED_STRING_KEY);
+			return false;
 		} else {
 			if (!readIdentifier(r, key, err)) {
 				return false;
 			}
 		}
 
-		skipWhitespace(r);
+		skipWhitespace<D>(r);
 
 		ch = r.peek();
 		if (ch != ':') {
-			error(r.loc(), err, "Expected colon ':'");
+			error(r, r.loc(), err, ERROR_EXPECTED_COLON);
 			return false;
 		}
 		r.get();
 
-		if (!parseValue(r, v[key], err, depth)) {
+		if (filter) {
+			if (!parseFilteredChild<D>(r, v, &key, 0, err, depth, *filter, child)) {
+				return false;
+			}
+		} else if (!parseValue<D>(r, memberForKey<D>(r, v, key), err, depth)) {
 			return false;
 		}
 	}
 }
 
+class ThreadPool;
+
+// Serialize using the threads in 'pool', or sequentially if it's null
+inline void serializeValue(
+		std::ostream &os, const Json::Value &v,
+		const SerializeConfig &conf, int depth, ThreadPool *pool);
+
 inline void serializeObject(
 		std::ostream &os, const Json::Value &v,
-		const SerializeConfig &conf, int depth) {
+		const SerializeConfig &conf, int depth, ThreadPool *pool) {
 	os << '{';
 	bool first = true;
 	for (auto it = v.begin(); it != v.end(); ++it) {
@@ -737,7 +2235,7 @@ inline void serializeObject(
 			os << ": ";
 		}
 
-		serializeValue(os, *it, conf, depth + 1);
+		serializeValue(os, *it, conf, depth + 1, pool);
 	}
 
 	if (!first) {
@@ -752,55 +2250,35 @@ inline void serializeObject(
 }
 
 // https://spec.json5.org/#prod-JSON5Array JSON5Array
-inline bool parseArray(Reader &r, Json::Value &v, std::string *err, int depth) {
+template<typename D>
+inline bool parseArray(
+		Reader &r, Json::Value &v, std::string *err, int depth,
+		const PathFilter *filter = nullptr) {
 	r.get(); // '['
 
 	v = Json::arrayValue;
+	PathFilter child;
 	Json::ArrayIndex index = 0;
+	bool first = true;
 	while (true) {
-		bool newline = skipWhitespace(r);
-		bool comma = false;
-
-		int ch = r.peek();
-		if (ch == EOF) {
-			error(r.loc(), err, "Unexpected EOF");
-			return false;
-		} else if (ch == ',') {
-			r.get();
-			skipWhitespace(r);
-			ch = r.peek();
-			if (ch == EOF) {
-				error(r.loc(), err, "Unexpected EOF");
-				return false;
-			}
-
-			comma = true;
-		}
-
-		if (ch == ']') {
-			r.get();
-			return true;
+		int next = skipSeparator<D>(r, ']', first, err);
+		if (next <= 0) {
+			return next == 0;
 		}
 
-		if (r.conf().newlinesAsCommas) {
-			if (!comma && !newline) {
-				error(r.loc(), err, "Expected ',', newline or ']'");
+		if (filter) {
+			if (!parseFilteredChild<D>(r, v, nullptr, index++, err, depth, *filter, child)) {
 				return false;
 			}
-		} else if (!comma) {
-			error(r.loc(), err, "Expected ',' or ']'");
+		} else if (!parseValue<D>(r, v[index++], err, depth)) {
 			return false;
 		}
-
-		if (!parseValue(r, v[index++], err, depth)) {
-			return false;
-		}
-	}
-}
+	}
+}
 
 inline void serializeArray(
 		std::ostream &os, const Json::Value &v,
-		const SerializeConfig &conf, int depth) {
+		const SerializeConfig &conf, int depth, ThreadPool *pool) {
 	os << '[';
 	bool first = true;
 	for (auto it = v.begin(); it != v.end(); ++it) {
@@ -810,7 +2288,7 @@ inline void serializeArray(
 		first = false;
 
 		serializeNewLine(os, conf, depth + 1);
-		serializeValue(os, *it, conf, depth + 1);
+		serializeValue(os, *it, conf, depth + 1, pool);
 	}
 
 	if (!first) {
@@ -824,34 +2302,163 @@ inline void serializeArray(
 	os << ']';
 }
 
+// Split a JSON pointer (https://datatracker.ietf.org/doc/html/rfc6901)
+// into its reference tokens
+inline bool parseJsonPointer(const std::string &ptr, std::vector<PathToken> &tokens) {
+	if (ptr.empty()) {
+		return true;
+	} else if (ptr[0] != '/') {
+		return false;
+	}
+
+	for (size_t i = 1; i <= ptr.size(); ++i) {
+		PathToken tok;
+		for (; i < ptr.size() && ptr[i] != '/'; ++i) {
+			char ch = ptr[i];
+			if (ch == '~') {
+				ch = i + 1 < ptr.size() ? ptr[++i] : '\0';
+				if (ch == '0') {
+					ch = '~';
+				} else if (ch == '1') {
+					ch = '/';
+				} else {
+					return false;
+				}
+			}
+
+			tok.key += ch;
+		}
+
+		tok.index = -1;
+		if (
+				!tok.key.empty() && tok.key.size() <= 18 &&
+				(tok.key == "0" || tok.key[0] != '0') &&
+				tok.key.find_first_not_of("0123456789") == std::string::npos) {
+			tok.index = std::stoll(tok.key);
+		}
+
+		tokens.push_back(std::move(tok));
+	}
+
+	return true;
+}
+
+// Parse or skip one object member or array element,
+// depending on whether any of the paths in 'filter' select it
+template<typename D>
+inline bool parseFilteredChild(
+		Reader &r, Json::Value &v, const std::string *key, Json::ArrayIndex index,
+		std::string *err, int depth, const PathFilter &filter, PathFilter &child) {
+	child.paths = filter.paths;
+	child.level = filter.level + 1;
+	child.active.clear();
+
+	bool whole = false;
+	for (size_t i: filter.active) {
+		const std::vector<PathToken> &path = (*filter.paths)[i];
+		const PathToken &tok = path[filter.level];
+		if (key ? tok.key != *key : tok.index != (long long)index) {
+			continue;
+		}
+
+		if (path.size() == child.level) {
+			whole = true;
+			break;
+		}
+
+		child.active.push_back(i);
+	}
+
+	if (child.active.empty() && !whole) {
+		return skipValue<D>(r, err, depth);
+	}
+
+	// Elements are selected in increasing order,
+	// so this only fills in the ones skipped since the last selected element
+	if (!key) {
+		for (Json::ArrayIndex i = v.size(); i < index; ++i) {
+			v[i] = Json::nullValue;
+		}
+	}
+
+	if (whole) {
+		return parseValue<D>(r, key ? memberForKey<D>(r, v, *key) : v[index], err, depth);
+	}
+
+	if (depth >= r.conf().maxDepth) {
+		error(r, r.loc(), err, ERROR_DEPTH_LIMIT);
+		return false;
+	}
+
+	// Only objects and arrays can contain the selected paths
+	skipWhitespace<D>(r);
+	size_t start = r.offset();
+	int ch = r.peek();
+	if (ch != '{' && ch != '[') {
+		return skipValue<D>(r, err, depth);
+	}
+
+	Json::Value &childValue = key ? memberForKey<D>(r, v, *key) : v[index];
+	size_t span = beginSpan(r, childValue, start);
+	bool ok;
+	if (ch == '{') {
+		ok = parseObject<D>(r, childValue, err, depth + 1, &child);
+	} else {
+		ok = parseArray<D>(r, childValue, err, depth + 1, &child);
+	}
+
+	if (ok) {
+		recordOffsets(r, childValue, start);
+		endSpan(r, span);
+	}
+
+	return ok;
+}
+
 // https://spec.json5.org/#values JSON5Value
+template<typename D>
 inline bool parseValue(Reader &r, Json::Value &v, std::string *err, int depth) {
 	if (depth >= r.conf().maxDepth) {
-		error(r.loc(), err, "Depth limit reached");
+		error(r, r.loc(), err, ERROR_DEPTH_LIMIT);
 		return false;
 	}
 
-	detail::skipWhitespace(r);
+	detail::skipWhitespace<D>(r);
 	Location loc = r.loc();
+	size_t start = r.offset();
+	size_t span = beginSpan(r, v, start);
 	int ch = r.peek();
+	bool ok = true;
 	if (ch == EOF) {
-		error(loc, err, "Unexpected EOF");
+		error(r, loc, err, ERROR_UNEXPECTED_EOF);
 		return false;
 	} else if (ch == '{') {
-		return detail::parseObject(r, v, err, depth + 1);
+		ok = detail::parseObject<D>(r, v, err, depth + 1);
 	} else if (ch == '[') {
-		return detail::parseArray(r, v, err, depth + 1);
-	} else if (ch == '"' || ch == '\'') {
-		std::string s;
-		if (!detail::readStringLiteral(r, s, err)) {
+		ok = detail::parseArray<D>(r, v, err, depth + 1);
+	} else if (ch == '"' || (D::json5 && ch == '\'')) {
+		std::string &s = r.scratch();
+		if (!detail::readStringLiteral<D>(r, s, err)) {
 			return false;
 		}
 		v = s;
-		return true;
-	} else if ((ch >= '0' && ch <= '9') || ch == '.' || ch == '+' || ch == '-') {
-		return detail::parseNumber(r, v, err);
+	} else if (
+			(ch >= '0' && ch <= '9') || ch == '-' ||
+			(D::json5 && (ch == '.' || ch == '+'))) {
+		if (r.conf().rawNumbers) {
+			std::string &s = r.scratch();
+			if (!detail::validateNumber<D>(r, err, s)) {
+				return false;
+			}
+
+			storeRawNumber(r, v, s, start);
+			endSpan(r, span);
+			return true;
+		}
+
+		ok = detail::parseNumber<D>(r, v, err);
 	} else {
-		std::string ident;
+		KeywordSink ident;
 		if (!detail::readIdentifier(r, ident, err)) {
 			return false;
 		}
@@ -862,65 +2469,2661 @@ inline bool parseValue(Reader &r, Json::Value &v, std::string *err, int depth) {
 			v = true;
 		} else if (ident == "false") {
 			v = false;
-		} else if (ident == "Infinity") {
-			v = std::numeric_limits<double>::infinity();
-		} else if (ident == "NaN") {
-			v = std::numeric_limits<double>::quiet_NaN();
+		} else if (D::json5 && (ident == "Infinity" || ident == "NaN")) {
+			if (r.conf().rawNumbers) {
+				storeRawNumber(r, v, ident == "NaN" ? "NaN" : "Infinity", start);
+				endSpan(r, span);
+				return true;
+			} else if (ident == "NaN") {
+				v = std::numeric_limits<double>::quiet_NaN();
+			} else {
+				v = std::numeric_limits<double>::infinity();
+			}
 		} else {
-			error(loc, err, "Invalid keyword");
+			error(r, loc, err, ERROR_INVALID_KEYWORD);
 			return false;
 		}
 	}
 
-	return true;
+	if (ok) {
+		recordOffsets(r, v, start);
+		endSpan(r, span);
+	}
+
+	return ok;
 }
 
-inline void serializeValue(
-		std::ostream &os, const Json::Value &v,
-		const SerializeConfig &conf, int depth) {
-	if (v.isObject()) {
-		serializeObject(os, v, conf, depth);
-	} else if (v.isArray()) {
-		serializeArray(os, v, conf, depth);
-	} else if (v.isString()) {
-		serializeStringLiteral(os, v.asCString());
+// Validate a https://spec.json5.org/#numbers JSON5Number.
+// This has to accept exactly the numbers parseNumber accepts,
+// including what jsoncpp accepts for the JSON number parseNumber creates.
+// The number's source text is appended to 'raw'.
+template<typename D, typename Sink>
+inline bool validateNumber(Reader &r, std::string *err, Sink &raw) {
+	Location loc = r.loc();
+
+	bool negative = false;
+	int ch = r.peek();
+	if (ch == '+') {
+		raw += r.get();
+		ch = r.peek();
+	} else if (ch == '-') {
+		negative = true;
+		raw += r.get();
+		ch = r.peek();
+	}
+
+	if (!D::json5 && !(ch >= '0' && ch <= '9')) {
+		error(r, loc, err, ERROR_INVALID_NUMBER);
+		return false;
+	}
+
+	if (ch == 'I' || ch == 'N') {
+		KeywordSink ident;
+		readIdentifier(r, ident, err);
+		if (ident == "Infinity" || ident == "NaN") {
+			raw.append(ident.buf, ident.len);
+			return true;
+		} else {
+			error(r, loc, err, ERROR_INVALID_NUMBER);
+			return false;
+		}
+	}
+
+	// Whether the integer or decimal part has any digits
+	bool hasDigits = false;
+	if (ch == '.') {
+		hasDigits = true;
+	} else if (ch == '0') {
+		hasDigits = true;
+		raw += r.get();
+		ch = r.peek();
+		if (!D::json5 && ch >= '0' && ch <= '9') {
+			error(r, loc, err, ERROR_INVALID_NUMBER);
+			return false;
+		} else if (D::json5 && (ch == 'x' || ch == 'X')) {
+			raw += r.get();
+			if (hexChar(r.peek()) == EOF) {
+				error(r, r.loc(), err, ERROR_UNEXPECTED_EOF);
+				return false;
+			}
+
+			while (hexChar(r.peek()) != EOF) {
+				raw += r.get();
+			}
+
+			return true;
+		} else if (!((ch >= '1' && ch <= '9') || ch == '.' || ch == 'e' || ch == 'E')) {
+			return true;
+		}
+	}
+
+	// jsoncpp rejects numbers which overflow a double.
+	// To detect that, track the decimal exponent of the first non-zero digit,
+	// and keep the first significant digits around for the borderline case.
+	long intDigits = 0;
+	long lead = -1; // Index of the first non-zero digit in the integer part
+	long fracLead = -1; // Index of the first non-zero digit in the decimal part
+	char sig[40];
+	size_t numSig = 0;
+
+	// Optional integer part
+	while (ch >= '0' && ch <= '9') {
+		if (lead < 0 && ch != '0') {
+			lead = intDigits;
+		}
+		if (lead >= 0 && numSig < sizeof(sig)) {
+			sig[numSig++] = ch;
+		}
+
+		hasDigits = true;
+		intDigits += 1;
+		raw += r.get();
+		ch = r.peek();
+	}
+
+	// Potentially trailing dot, parseNumber adds a '0' after it
+	if (ch == '.') {
+		hasDigits = true;
+		raw += r.get();
+		ch = r.peek();
+		if (!D::json5 && !(ch >= '0' && ch <= '9')) {
+			error(r, loc, err, ERROR_INVALID_NUMBER);
+			return false;
+		}
+	}
+
+	// Optional decimal part
+	long fracDigits = 0;
+	while (ch >= '0' && ch <= '9') {
+		if (lead < 0 && fracLead < 0 && ch != '0') {
+			fracLead = fracDigits;
+		}
+		if ((lead >= 0 || fracLead >= 0) && numSig < sizeof(sig)) {
+			sig[numSig++] = ch;
+		}
+
+		fracDigits += 1;
+		raw += r.get();
+		ch = r.peek();
+	}
+
+	// Optional exponent part
+	long exponent = 0;
+	if (ch == 'e' || ch == 'E') {
+		raw += r.get();
+		ch = r.peek();
+		bool negativeExponent = false;
+		if (ch == '+' || ch == '-') {
+			negativeExponent = ch == '-';
+			raw += r.get();
+			ch = r.peek();
+		}
+
+		bool hasExponentDigits = false;
+		while (ch >= '0' && ch <= '9') {
+			hasExponentDigits = true;
+			if (exponent < 1000000) {
+				exponent = exponent * 10 + (ch - '0');
+			}
+			raw += r.get();
+			ch = r.peek();
+		}
+
+		if (!hasDigits || !hasExponentDigits) {
+			error(r, loc, err, ERROR_INVALID_NUMBER);
+			return false;
+		}
+
+		if (negativeExponent) {
+			exponent = -exponent;
+		}
+	} else if (!hasDigits) {
+		// A lone '-' is a valid JSON number to jsoncpp, but an empty string isn't
+		if (!negative) {
+			error(r, loc, err, ERROR_INVALID_NUMBER);
+			return false;
+		}
+
+		return true;
+	}
+
+	if (lead < 0 && fracLead < 0) {
+		// Zero never overflows
+		return true;
+	}
+
+	long leadExponent = exponent + (lead >= 0 ? intDigits - 1 - lead : -(fracLead + 1));
+	if (leadExponent < std::numeric_limits<double>::max_exponent10) {
+		return true;
+	} else if (leadExponent == std::numeric_limits<double>::max_exponent10) {
+		char buf[sizeof(sig) + 16];
+		snprintf(buf, sizeof(buf), "%.1s.%.*se%ld",
+			sig, (int)numSig - 1, sig + 1, leadExponent);
+		if (strtod(buf, nullptr) != std::numeric_limits<double>::infinity()) {
+			return true;
+		}
+	}
+
+	error(r, loc, err, ERROR_INVALID_NUMBER);
+	return false;
+}
+
+template<typename D>
+inline bool validateNumber(Reader &r, std::string *err) {
+	NullSink raw;
+	return validateNumber<D>(r, err, raw);
+}
+
+// https://spec.json5.org/#prod-JSON5Object JSON5Object
+template<typename D>
+inline bool validateObject(Reader &r, std::string *err, int depth) {
+	r.get(); // '{'
+
+	bool first = true;
+	while (true) {
+		int next = skipSeparator<D>(r, '}', first, err);
+		if (next <= 0) {
+			return next == 0;
+		}
+
+		int ch = r.peek();
+		NullSink key;
+		if (ch == '"' || (D::json5 && ch == '\'')) {
+			if (!readStringLiteral<D>(r, key, err)) {
+				return false;
+			}
+		} else if (!D::json5) {
+			error(r, r.loc(), err, ERROR_EXPECTED_STRING_KEY);
+			return false;
+		} else {
+			if (!readIdentifier(r, key, err)) {
+				return false;
+			}
+		}
+
+		skipWhitespace<D>(r);
+
+		ch = r.peek();
+		if (ch != ':') {
+			error(r, r.loc(), err, ERROR_EXPECTED_COLON);
+			return false;
+		}
+		r.get();
+
+		if (!validateValue<D>(r, err, depth)) {
+			return false;
+		}
+	}
+}
+
+// https://spec.json5.org/#prod-JSON5Array JSON5Array
+template<typename D>
+inline bool validateArray(Reader &r, std::string *err, int depth) {
+	r.get(); // '['
+
+	bool first = true;
+	while (true) {
+		int next = skipSeparator<D>(r, ']', first, err);
+		if (next <= 0) {
+			return next == 0;
+		}
+
+		if (!validateValue<D>(r, err, depth)) {
+			return false;
+		}
+	}
+}
+
+// https://spec.json5.org/#values JSON5Value
+template<typename D>
+inline bool validateValue(Reader &r, std::string *err, int depth) {
+	if (depth >= r.conf().maxDepth) {
+		error(r, r.loc(), err, ERROR_DEPTH_LIMIT);
+		return false;
+	}
+
+	detail::skipWhitespace<D>(r);
+	Location loc = r.loc();
+	int ch = r.peek();
+	if (ch == EOF) {
+		error(r, loc, err, ERROR_UNEXPECTED_EOF);
+		return false;
+	} else if (ch == '{') {
+		return detail::validateObject<D>(r, err, depth + 1);
+	} else if (ch == '[') {
+		return detail::validateArray<D>(r, err, depth + 1);
+	} else if (ch == '"' || (D::json5 && ch == '\'')) {
+		NullSink s;
+		return detail::readStringLiteral<D>(r, s, err);
+	} else if (
+			(ch >= '0' && ch <= '9') || ch == '-' ||
+			(D::json5 && (ch == '.' || ch == '+'))) {
+		return detail::validateNumber<D>(r, err);
 	} else {
-		os << v;
+		KeywordSink ident;
+		if (!detail::readIdentifier(r, ident, err)) {
+			return false;
+		}
+
+		if (
+				!(ident == "null") && !(ident == "true") && !(ident == "false") &&
+				!(D::json5 && (ident == "Infinity" || ident == "NaN"))) {
+			error(r, loc, err, ERROR_INVALID_KEYWORD);
+			return false;
+		}
 	}
+
+	return true;
 }
 
+inline void compilePaths(const std::vector<std::string> &ptrs, PathSelection &sel) {
+	sel.filter.paths = &sel.paths;
+	for (const std::string &ptr: ptrs) {
+		sel.paths.emplace_back();
+		if (!parseJsonPointer(ptr, sel.paths.back())) {
+			sel.valid = false;
+		} else if (sel.paths.back().empty()) {
+			sel.whole = true;
+		}
+
+		sel.filter.active.push_back(sel.paths.size() - 1);
+	}
 }
 
-#ifndef JSON5CPP_IMPL
-inline
-#endif
-bool parse(
-		std::istream &is, Json::Value &v,
-		std::string *err, ParseConfig conf) {
-	detail::Reader r(is, conf);
+// Parse a whole document, with nothing but whitespace after the value
+template<typename D>
+inline bool parseDocument(
+		Reader &r, Json::Value &v, std::string *err,
+		const PathSelection *sel) {
+	if (sel && !sel->valid) {
+		error(r, r.loc(), err, ERROR_INVALID_PATHS);
+		return false;
+	}
 
-	if (!detail::parseValue(r, v, err, 0)) {
+	if (sel && !sel->whole) {
+		skipWhitespace<D>(r);
+		size_t start = r.offset();
+		int ch = r.peek();
+		bool ok;
+		if (!r.conf().merge) {
+			v = Json::nullValue;
+		}
+
+		size_t span = 0;
+		if (ch == '{' || ch == '[') {
+			span = beginSpan(r, v, start);
+		}
+
+		if (ch == '{') {
+			ok = parseObject<D>(r, v, err, 1, &sel->filter);
+		} else if (ch == '[') {
+			ok = parseArray<D>(r, v, err, 1, &sel->filter);
+		} else {
+			ok = skipValue<D>(r, err, 0);
+		}
+
+		if (!ok) {
+			return false;
+		} else if (ch == '{' || ch == '[') {
+			recordOffsets(r, v, start);
+			endSpan(r, span);
+		}
+	} else if (!parseValue<D>(r, v, err, 0)) {
 		return false;
 	}
 
-	detail::skipWhitespace(r);
+	skipWhitespace<D>(r);
 	if (r.peek() != EOF) {
-		detail::error(r.loc(), err, "Trailing garbage");
+		error(r, r.loc(), err, ERROR_TRAILING_GARBAGE);
 		return false;
 	}
 
 	return true;
 }
 
-#ifndef JSON5CPP_IMPL
-inline
-#endif
-void serialize(
-		std::ostream &os, const Json::Value &v,
+// Parse a whole document with the dialect the reader's config asks for
+inline bool parseDocument(
+		Reader &r, Json::Value &v, std::string *err,
+		const PathSelection *sel) {
+	if (r.conf().strictJson) {
+		return parseDocument<JsonDialect>(r, v, err, sel);
+	} else if (r.conf().newlinesAsCommas) {
+		return parseDocument<Json5NewlinesDialect>(r, v, err, sel);
+	} else {
+		return parseDocument<Json5Dialect>(r, v, err, sel);
+	}
+}
+
+template<typename D>
+inline bool validateDocument(Reader &r, std::string *err) {
+	if (!validateValue<D>(r, err, 0)) {
+		return false;
+	}
+
+	skipWhitespace<D>(r);
+	if (r.peek() != EOF) {
+		error(r, r.loc(), err, ERROR_TRAILING_GARBAGE);
+		return false;
+	}
+
+	return true;
+}
+
+inline bool validateDocument(Reader &r, std::string *err) {
+	if (r.conf().strictJson) {
+		return validateDocument<JsonDialect>(r, err);
+	} else if (r.conf().newlinesAsCommas) {
+		return validateDocument<Json5NewlinesDialect>(r, err);
+	} else {
+		return validateDocument<Json5Dialect>(r, err);
+	}
+}
+
+// Errors which aren't about a location in the input
+inline void fileError(const char *what, const char *path, std::string *err) {
+	if (!err) {
+		return;
+	}
+
+	*err = what;
+	*err += ' ';
+	*err += path;
+}
+
+// File errors don't have a position in the input
+inline void ioError(ParseError *out) {
+	if (out) {
+		*out = ParseError();
+		out->code = ERROR_IO;
+	}
+}
+
+// Append the rest of an open file to 'data'
+inline bool readFile(FILE *f, const char *path, std::string &data, std::string *err) {
+	char buf[16 * 1024];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		data.append(buf, n);
+	}
+
+	if (ferror(f)) {
+		fileError("Couldn't read", path, err);
+		return false;
+	}
+
+	return true;
+}
+
+inline bool readFile(const char *path, std::string &data, std::string *err) {
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		fileError("Couldn't open", path, err);
+		return false;
+	}
+
+	bool ok = readFile(f, path, data, err);
+	fclose(f);
+	return ok;
+}
+
+// FNV-1a, to notice when a file's contents change
+inline unsigned long long hashContents(const std::string &data) {
+	unsigned long long hash = 14695981039346656037ull;
+	for (unsigned char ch: data) {
+		hash ^= ch;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+struct FileCacheEntry {
+	long long size = 0;
+	long long mtime = 0;
+	long long mtimeNsec = 0;
+	unsigned long long hash = 0;
+	std::shared_ptr<const Json::Value> value;
+};
+
+struct FileCacheState {
+	ParseConfig conf;
+	bool hashContents;
+	std::mutex mut;
+	std::map<std::string, FileCacheEntry> entries;
+};
+
+struct SharedDocumentState {
+	SharedDocumentState(ParseConfig conf):
+			conf(conf),
+			current(new std::shared_ptr<const Json::Value>(
+				std::make_shared<const Json::Value>())) {
+		// Documents can be parsed on many threads at once
+		this->conf.error = nullptr;
+		this->conf.sourceMap = nullptr;
+		readers[0] = 0;
+		readers[1] = 0;
+	}
+
+	~SharedDocumentState() {
+		delete current.load();
+	}
+
+	// Readers copy the shared_ptr which 'current' points to,
+	// while counted in 'readers[epoch & 1]'.
+	// Re-checking the epoch after counting itself makes sure that a reader
+	// which was slow to count itself doesn't count in a slot which is being waited on.
+	std::shared_ptr<const Json::Value> get() {
+		while (true) {
+			unsigned long long e = epoch.load();
+			readers[e & 1].fetch_add(1);
+			if (epoch.load() != e) {
+				readers[e & 1].fetch_sub(1);
+				continue;
+			}
+
+			std::shared_ptr<const Json::Value> doc = *current.load();
+			readers[e & 1].fetch_sub(1);
+			return doc;
+		}
+	}
+
+	// Swap in the new document, then move readers to the other slot.
+	// Only readers counted in the old slot can still be copying the old document,
+	// readers which count themselves after the flip see the new one.
+	// Publishers are serialized, so the other slot was drained by the previous publish.
+	void publish(std::shared_ptr<const Json::Value> doc) {
+		std::lock_guard<std::mutex> lock(publishMut);
+		std::shared_ptr<const Json::Value> *old = current.exchange(
+			new std::shared_ptr<const Json::Value>(std::move(doc)));
+
+		unsigned long long e = epoch.fetch_add(1);
+		while (readers[e & 1].load() != 0) {
+			std::this_thread::yield();
+		}
+
+		delete old;
+	}
+
+	ParseConfig conf;
+	std::atomic<std::shared_ptr<const Json::Value> *> current;
+	std::atomic<unsigned long long> epoch{0};
+	std::atomic<unsigned long> readers[2];
+	std::mutex publishMut;
+};
+
+// Find the smallest value in 'v' which strictly contains the bytes [begin, end),
+// meaning that the edit doesn't touch its first or last character
+inline Json::Value *findEnclosingValue(
+		Json::Value &v, size_t begin, size_t end, int &depth) {
+	if (!((size_t)v.getOffsetStart() < begin && end < (size_t)v.getOffsetLimit())) {
+		return nullptr;
+	}
+
+	Json::Value *found = &v;
+	while (true) {
+		Json::Value *child = nullptr;
+		if (found->isArray() && found->size() > 0) {
+			// Array elements are in source order, so we can binary search
+			Json::ArrayIndex lo = 0;
+			Json::ArrayIndex hi = found->size();
+			while (hi - lo > 1) {
+				Json::ArrayIndex mid = lo + (hi - lo) / 2;
+				if ((size_t)(*found)[mid].getOffsetStart() < begin) {
+					lo = mid;
+				} else {
+					hi = mid;
+				}
+			}
+
+			child = &(*found)[lo];
+		} else if (found->isObject()) {
+			for (auto it = found->begin(); it != found->end(); ++it) {
+				if ((size_t)it->getOffsetStart() < begin && end < (size_t)it->getOffsetLimit()) {
+					child = &*it;
+					break;
+				}
+			}
+		}
+
+		if (!child || !(
+				(size_t)child->getOffsetStart() < begin &&
+				end < (size_t)child->getOffsetLimit())) {
+			return found;
+		}
+
+		found = child;
+		depth += 1;
+	}
+}
+
+// Shift the offsets of everything at or after 'end' by 'delta',
+// except for the subtree 'skip'
+inline void shiftOffsets(
+		Json::Value &v, size_t end, ptrdiff_t delta, const Json::Value *skip) {
+	if (&v == skip || (size_t)v.getOffsetLimit() < end) {
+		return;
+	}
+
+	if ((size_t)v.getOffsetStart() >= end) {
+		v.setOffsetStart(v.getOffsetStart() + delta);
+	}
+	v.setOffsetLimit(v.getOffsetLimit() + delta);
+
+	if (v.isObject() || v.isArray()) {
+		for (auto it = v.begin(); it != v.end(); ++it) {
+			shiftOffsets(*it, end, delta, skip);
+		}
+	}
+}
+
+// The snapshot format. All integers are in native byte order.
+// The header is the magic "J5SN", then the format version,
+// the offset of the root value and the total size, each as a uint32.
+// Each value starts with a tag byte, followed by:
+//   null, false, true: nothing
+//   int, uint, real: an int64, uint64 or double
+//   string: a uint32 length, the bytes, and a NUL
+//   array: a uint32 count, and the offset of each element as a uint32
+//   object: a uint32 count, and the offsets of each member's key
+//     (a string value) and value as uint32s, sorted by key
+// Values are written before the arrays/objects which contain them,
+// so a valid child's offset is always smaller than its parent's.
+enum SnapshotTag: unsigned char {
+	SNAPSHOT_NULL,
+	SNAPSHOT_FALSE,
+	SNAPSHOT_TRUE,
+	SNAPSHOT_INT,
+	SNAPSHOT_UINT,
+	SNAPSHOT_REAL,
+	SNAPSHOT_STRING,
+	SNAPSHOT_ARRAY,
+	SNAPSHOT_OBJECT,
+};
+
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+static constexpr size_t SNAPSHOT_HEADER_SIZE = 16;
+
+// Writing and copying snapshots recurses, so the nesting depth is bounded
+// like the parser's; children before parents alone still allows
+// millions of levels in a corrupt snapshot
+static constexpr int SNAPSHOT_MAX_DEPTH = 1000;
+
+// Returns the snapshot's size, or 0 if 'data' doesn't start with a valid header
+inline size_t snapshotSize(const void *data, size_t size) {
+	uint32_t header[4];
+	if (size < SNAPSHOT_HEADER_SIZE) {
+		return 0;
+	}
+
+	memcpy(header, data, sizeof(header));
+	if (
+			memcmp(data, "J5SN", 4) != 0 || header[1] != SNAPSHOT_VERSION ||
+			header[3] > size || header[2] < SNAPSHOT_HEADER_SIZE || header[2] >= header[3]) {
+		return 0;
+	}
+
+	return header[3];
+}
+
+struct SnapshotBuilder {
+	std::string out;
+	std::map<std::string, uint32_t> strings;
+	uint32_t constants[3] = {}; // null, false and true, 0 until written
+	bool tooDeep = false;
+
+	uint32_t offset() {
+		return (uint32_t)out.size();
+	}
+
+	template<typename T>
+	void put(T x) {
+		out.append((const char *)&x, sizeof(x));
+	}
+
+	uint32_t addConstant(SnapshotTag tag) {
+		if (constants[tag] == 0) {
+			constants[tag] = offset();
+			put(tag);
+		}
+
+		return constants[tag];
+	}
+
+	uint32_t addString(const char *begin, const char *end) {
+		std::string str(begin, end);
+		auto it = strings.find(str);
+		if (it != strings.end()) {
+			return it->second;
+		}
+
+		uint32_t at = offset();
+		put(SNAPSHOT_STRING);
+		put((uint32_t)str.size());
+		out.append(str.c_str(), str.size() + 1);
+		strings.emplace(std::move(str), at);
+		return at;
+	}
+
+	uint32_t add(const Json::Value &v, int depth) {
+		// Raw numbers become real numbers; the format has no raw text
+		if (isRawNumber(v)) {
+			return add(convertNumber(v), depth);
+		}
+
+		uint32_t at;
+		switch (v.type()) {
+		case Json::nullValue:
+			return addConstant(SNAPSHOT_NULL);
+
+		case Json::booleanValue:
+			return addConstant(v.asBool() ? SNAPSHOT_TRUE : SNAPSHOT_FALSE);
+
+		case Json::intValue:
+			at = offset();
+			put(SNAPSHOT_INT);
+			put((int64_t)v.asInt64());
+			return at;
+
+		case Json::uintValue:
+			at = offset();
+			put(SNAPSHOT_UINT);
+			put((uint64_t)v.asUInt64());
+			return at;
+
+		case Json::realValue:
+			at = offset();
+			put(SNAPSHOT_REAL);
+			put(v.asDouble());
+			return at;
+
+		case Json::stringValue: {
+			const char *begin, *end;
+			v.getString(&begin, &end);
+			return addString(begin, end);
+		}
+
+		case Json::arrayValue: {
+			if (depth >= SNAPSHOT_MAX_DEPTH) {
+				tooDeep = true;
+				return addConstant(SNAPSHOT_NULL);
+			}
+
+			std::vector<uint32_t> elements;
+			elements.reserve(v.size());
+			for (const Json::Value &element: v) {
+				elements.push_back(add(element, depth + 1));
+			}
+
+			at = offset();
+			put(SNAPSHOT_ARRAY);
+			put((uint32_t)elements.size());
+			out.append((const char *)elements.data(), elements.size() * sizeof(uint32_t));
+			return at;
+		}
+
+		case Json::objectValue: {
+			if (depth >= SNAPSHOT_MAX_DEPTH) {
+				tooDeep = true;
+				return addConstant(SNAPSHOT_NULL);
+			}
+
+			// jsoncpp keeps members sorted by comparing the key bytes, then lengths,
+			// which is the order SnapshotValue::find searches in
+			std::vector<uint32_t> members;
+			members.reserve(v.size() * 2);
+			for (auto it = v.begin(); it != v.end(); ++it) {
+				const char *end;
+				const char *begin = it.memberName(&end);
+				members.push_back(addString(begin, end));
+				members.push_back(add(*it, depth + 1));
+			}
+
+			at = offset();
+			put(SNAPSHOT_OBJECT);
+			put((uint32_t)(members.size() / 2));
+			out.append((const char *)members.data(), members.size() * sizeof(uint32_t));
+			return at;
+		}
+		}
+
+		return addConstant(SNAPSHOT_NULL);
+	}
+};
+
+#ifdef JSON5CPP_ZLIB
+inline bool isGzip(const char *data, size_t size) {
+	return size >= 2 && (unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b;
+}
+
+// Decompresses gzip or zlib data from a stream, a file or memory.
+// zlib only uses its fast path with a decent amount of output space,
+// so we inflate into our own buffer rather than the Reader's small one.
+class InflateSource: public Source {
+public:
+	InflateSource(std::istream &is): is_(&is) {
+		init();
+	}
+
+	// 'head' is what has already been read from the file
+	InflateSource(FILE *f, const char *head, size_t headSize): file_(f) {
+		init();
+		headSize = std::min(headSize, sizeof(in_));
+		memcpy(in_, head, headSize);
+		zs_.next_in = in_;
+		zs_.avail_in = (uInt)headSize;
+	}
+
+	InflateSource(const char *data, size_t size):
+			data_((const unsigned char *)data), dataSize_(size) {
+		init();
+		refill();
+	}
+
+	~InflateSource() {
+		inflateEnd(&zs_);
+	}
+
+	size_t read(unsigned char *buf, size_t size) override {
+		if (outIndex_ == outSize_) {
+			inflateMore();
+		}
+
+		size_t n = std::min(size, outSize_ - outIndex_);
+		memcpy(buf, out_ + outIndex_, n);
+		outIndex_ += n;
+		return n;
+	}
+
+	bool failed() {
+		return failed_;
+	}
+
+private:
+	void init() {
+		memset(&zs_, 0, sizeof(zs_));
+		// 32 makes zlib detect gzip and zlib headers automatically
+		failed_ = inflateInit2(&zs_, 15 + 32) != Z_OK;
+	}
+
+	void inflateMore() {
+		zs_.next_out = out_;
+		zs_.avail_out = sizeof(out_);
+		while (!failed_ && !done_ && zs_.avail_out == sizeof(out_)) {
+			if (zs_.avail_in == 0 && !refill()) {
+				failed_ = true; // Truncated input
+				break;
+			}
+
+			int ret = inflate(&zs_, Z_NO_FLUSH);
+			if (ret == Z_STREAM_END) {
+				// Multiple concatenated gzip members make up one document
+				if (zs_.avail_in == 0 && !refill()) {
+					done_ = true;
+				} else {
+					inflateReset(&zs_);
+				}
+			} else if (ret != Z_OK) {
+				failed_ = true;
+			}
+		}
+
+		outIndex_ = 0;
+		outSize_ = sizeof(out_) - zs_.avail_out;
+	}
+
+	bool refill() {
+		if (file_) {
+			zs_.next_in = in_;
+			zs_.avail_in = (uInt)fread(in_, 1, sizeof(in_), file_);
+			return zs_.avail_in > 0;
+		} else if (!is_) {
+			// avail_in is a uInt, so inputs of 4 GiB and more go in several pieces
+			size_t n = std::min(dataSize_, (size_t)std::numeric_limits<uInt>::max());
+			zs_.next_in = (Bytef *)data_;
+			zs_.avail_in = (uInt)n;
+			data_ += n;
+			dataSize_ -= n;
+			return n > 0;
+		}
+
+		zs_.next_in = in_;
+		zs_.avail_in = (uInt)is_->read((char *)in_, sizeof(in_)).gcount();
+		return zs_.avail_in > 0;
+	}
+
+	z_stream zs_;
+	std::istream *is_ = nullptr;
+	FILE *file_ = nullptr;
+	const unsigned char *data_ = nullptr;
+	size_t dataSize_ = 0;
+	bool failed_ = false;
+	bool done_ = false;
+	unsigned char in_[16 * 1024];
+	unsigned char out_[16 * 1024];
+	size_t outIndex_ = 0;
+	size_t outSize_ = 0;
+};
+
+inline bool parseInflated(
+		InflateSource &source, Json::Value &v, std::string *err,
+		const ParseConfig &conf) {
+	Reader r(conf);
+	r.reset(source);
+
+	bool ok;
+	if (conf.paths) {
+		PathSelection sel;
+		compilePaths(*conf.paths, sel);
+		ok = parseDocument(r, v, err, &sel);
+	} else {
+		ok = parseDocument(r, v, err, nullptr);
+	}
+
+	if (source.failed()) {
+		error(r, r.loc(), err, ERROR_INVALID_COMPRESSED_DATA);
+		return false;
+	}
+
+	return ok;
+}
+
+struct DeflateBuf: public std::streambuf {
+	DeflateBuf(std::ostream &os, int level): os_(os) {
+		memset(&zs_, 0, sizeof(zs_));
+		// 16 makes zlib write a gzip header
+		ok_ = deflateInit2(
+				&zs_, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+		setp((char *)in_, (char *)in_ + sizeof(in_));
+	}
+
+	~DeflateBuf() {
+		deflateEnd(&zs_);
+	}
+
+	int overflow(int ch) override {
+		if (!compress(Z_NO_FLUSH)) {
+			return EOF;
+		}
+
+		if (ch != EOF) {
+			*pptr() = (char)ch;
+			pbump(1);
+			return ch;
+		}
+
+		return 0;
+	}
+
+	int sync() override {
+		// Don't do a zlib flush, which would hurt the compression ratio
+		if (!compress(Z_NO_FLUSH)) {
+			return -1;
+		}
+
+		os_.flush();
+		return 0;
+	}
+
+	bool finish() {
+		if (!finished_) {
+			finished_ = true;
+			compress(Z_FINISH);
+			os_.flush();
+		}
+
+		return ok_ && os_;
+	}
+
+	bool compress(int flush) {
+		if (!ok_ || finished_ != (flush == Z_FINISH)) {
+			return false;
+		}
+
+		zs_.next_in = in_;
+		zs_.avail_in = (uInt)(pptr() - pbase());
+		do {
+			zs_.next_out = out_;
+			zs_.avail_out = sizeof(out_);
+			if (deflate(&zs_, flush) == Z_STREAM_ERROR) {
+				ok_ = false;
+				return false;
+			}
+
+			os_.write((const char *)out_, sizeof(out_) - zs_.avail_out);
+		} while (zs_.avail_out == 0);
+
+		setp((char *)in_, (char *)in_ + sizeof(in_));
+		ok_ = ok_ && os_;
+		return ok_;
+	}
+
+	std::ostream &os_;
+	z_stream zs_;
+	bool ok_;
+	bool finished_ = false;
+	unsigned char in_[16 * 1024];
+	unsigned char out_[16 * 1024];
+};
+#endif
+
+// The number of threads to use when asked for 'threads',
+// where 0 means one thread per CPU core.
+// hardware_concurrency returns 0 if the number of cores isn't known.
+inline unsigned int threadCount(unsigned int threads) {
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	return threads;
+}
+
+// Run 'fn' on 'threads' threads (including the calling thread)
+// and wait for all of them to finish.
+// 0 means one thread per CPU core.
+template<typename Fn>
+inline void runThreads(unsigned int threads, Fn fn) {
+	threads = threadCount(threads);
+
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i < threads; ++i) {
+		workers.emplace_back(fn);
+	}
+
+	fn();
+	for (std::thread &t: workers) {
+		t.join();
+	}
+}
+
+// Like runThreads, but the threads are kept around between jobs,
+// so running many jobs only starts threads once.
+// They're started the first time a job is run.
+class ThreadPool {
+public:
+	ThreadPool(unsigned int threads): threads_(threads) {}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mut_);
+			stopping_ = true;
+		}
+		start_.notify_all();
+
+		for (std::thread &t: workers_) {
+			t.join();
+		}
+	}
+
+	// The number of threads a job runs on (including the calling thread)
+	unsigned int size() const {
+		return threadCount(threads_);
+	}
+
+	// Run 'fn' on every thread and wait for all of them to finish
+	void run(const std::function<void()> &fn) {
+		if (workers_.empty()) {
+			for (unsigned int i = 1; i < size(); ++i) {
+				workers_.emplace_back([this] { work(); });
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mut_);
+			job_ = &fn;
+			generation_ += 1;
+			running_ = workers_.size();
+		}
+		start_.notify_all();
+
+		fn();
+		std::unique_lock<std::mutex> lock(mut_);
+		done_.wait(lock, [&] { return running_ == 0; });
+		job_ = nullptr;
+	}
+
+private:
+	void work() {
+		unsigned long long seen = 0;
+		while (true) {
+			const std::function<void()> *job;
+			{
+				std::unique_lock<std::mutex> lock(mut_);
+				start_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+				if (stopping_) {
+					return;
+				}
+
+				seen = generation_;
+				job = job_;
+			}
+
+			(*job)();
+
+			std::lock_guard<std::mutex> lock(mut_);
+			running_ -= 1;
+			if (running_ == 0) {
+				done_.notify_one();
+			}
+		}
+	}
+
+	unsigned int threads_;
+	std::vector<std::thread> workers_;
+	std::mutex mut_;
+	std::condition_variable start_;
+	std::condition_variable done_;
+	const std::function<void()> *job_ = nullptr;
+	unsigned long long generation_ = 0;
+	size_t running_ = 0;
+	bool stopping_ = false;
+};
+
+// Serialize an object/array by splitting its children across the pool's threads.
+// Each thread serializes a chunk of children into its own buffer,
+// then waits for its turn to write it out, so the output is the same
+// as serializing sequentially, and only a few chunks are in memory at once.
+inline void serializeParallel(
+		std::ostream &os, const Json::Value &v,
+		const SerializeConfig &conf, int depth, ThreadPool &pool) {
+	std::vector<Json::Value::const_iterator> children;
+	children.reserve(v.size());
+	for (auto it = v.begin(); it != v.end(); ++it) {
+		children.push_back(it);
+	}
+
+	const unsigned int threads = pool.size();
+
+	const size_t chunk = std::max<size_t>(1, children.size() / (threads * 8));
+	const size_t count = (children.size() + chunk - 1) / chunk;
+	std::atomic<size_t> next(0);
+	size_t written = 0;
+	std::mutex mut;
+	std::condition_variable cond;
+
+	os << (v.isObject() ? '{' : '[');
+	pool.run([&] {
+		std::ostringstream buf;
+		size_t index;
+		while ((index = next.fetch_add(1)) < count) {
+			buf.str("");
+			size_t end = std::min((index + 1) * chunk, children.size());
+			for (size_t i = index * chunk; i < end; ++i) {
+				if (i != 0) {
+					buf << ',';
+				}
+
+				serializeNewLine(buf, conf, depth + 1);
+
+				if (v.isObject()) {
+					serializeIdentifier(buf, children[i].key().asCString(), conf);
+					if (conf.indent == nullptr) {
+						buf << ":";
+					} else {
+						buf << ": ";
+					}
+				}
+
+				// Only the outermost big container is split up,
+				// nested ones are serialized sequentially within each chunk
+				serializeValue(buf, *children[i], conf, depth + 1, nullptr);
+			}
+
+			std::unique_lock<std::mutex> lock(mut);
+			cond.wait(lock, [&] { return written == index; });
+			os << buf.str();
+			written += 1;
+			cond.notify_all();
+		}
+	});
+
+	if (!children.empty()) {
+		if (conf.trailingCommas) {
+			os << ',';
+		}
+
+		serializeNewLine(os, conf, depth);
+	}
+
+	os << (v.isObject() ? '}' : ']');
+}
+
+struct ParserState {
+	ParserState(ParseConfig conf): reader(conf) {
+		if (conf.paths) {
+			compilePaths(*conf.paths, selection);
+		}
+	}
+
+	Reader reader;
+	PathSelection selection;
+};
+
+#if JSON5CPP_POSIX
+// Find the files for loadDirectory, recursing into subdirectories.
+// Hidden files and directories are skipped. Symlinks to files are followed,
+// symlinks to directories aren't, so that a symlink loop can't make us recurse forever.
+// A directory which can't be listed gets an error result of its own.
+inline void listDirectory(
+		const std::string &dir, const std::string &extension,
+		std::vector<std::string> &files, std::map<std::string, ParseResult> &results) {
+	DIR *d = opendir(dir.c_str());
+	if (!d) {
+		ParseResult &res = results[dir];
+		fileError("Couldn't open", dir.c_str(), &res.err);
+		ioError(&res.error);
+		return;
+	}
+
+	std::vector<std::string> subdirs;
+	while (struct dirent *ent = readdir(d)) {
+		if (ent->d_name[0] == '.') {
+			continue;
+		}
+
+		std::string path = dir == "/" ? dir + ent->d_name : dir + '/' + ent->d_name;
+		unsigned char type = ent->d_type;
+		struct stat st;
+		if (type == DT_UNKNOWN && lstat(path.c_str(), &st) == 0) {
+			if (S_ISDIR(st.st_mode)) {
+				type = DT_DIR;
+			} else if (S_ISREG(st.st_mode)) {
+				type = DT_REG;
+			} else if (S_ISLNK(st.st_mode)) {
+				type = DT_LNK;
+			}
+		}
+		if (type == DT_LNK && stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+			type = DT_REG;
+		}
+
+		if (type == DT_DIR) {
+			subdirs.push_back(std::move(path));
+		} else if (
+				type == DT_REG && path.size() >= extension.size() &&
+				path.compare(path.size() - extension.size(), extension.size(), extension) == 0) {
+			files.push_back(std::move(path));
+		}
+	}
+	closedir(d);
+
+	// Recurse after closing the directory, so deep trees don't use up file descriptors
+	for (const std::string &subdir: subdirs) {
+		listDirectory(subdir, extension, files, results);
+	}
+}
+
+// Read and parse one file for loadDirectory.
+// 'parser' must be made from 'conf', whose 'error' is where errors go
+// before they're copied into the result.
+// Small files are read into 'buf' with as few reads as possible,
+// which is cheaper than mapping them; big files are mapped.
+inline void loadDirectoryFile(
+		Parser &parser, const ParseConfig &conf, const std::string &path,
+		std::string &buf, ParseResult &res) {
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		fileError("Couldn't open", path.c_str(), &res.err);
+		ioError(&res.error);
+		return;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		fileError("Couldn't read", path.c_str(), &res.err);
+		ioError(&res.error);
+		return;
+	}
+
+	const char *data = nullptr;
+	size_t size = 0;
+	void *mapping = nullptr;
+	if (st.st_size >= 1024 * 1024) {
+		mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping == MAP_FAILED) {
+			mapping = nullptr;
+		} else {
+			data = (const char *)mapping;
+			size = st.st_size;
+		}
+	}
+
+	if (!mapping) {
+		// One byte extra, so that reaching the end of the file
+		// normally doesn't take another read to notice
+		buf.resize((size_t)st.st_size + 1);
+		while (true) {
+			ssize_t n = read(fd, &buf[size], buf.size() - size);
+			if (n < 0) {
+				close(fd);
+				fileError("Couldn't read", path.c_str(), &res.err);
+				ioError(&res.error);
+				return;
+			} else if (n == 0) {
+				break;
+			}
+
+			size += n;
+			if (size == buf.size()) {
+				buf.resize(buf.size() * 2);
+			}
+		}
+		data = buf.data();
+	}
+	close(fd);
+
+#ifdef JSON5CPP_ZLIB
+	if (isGzip(data, size)) {
+		InflateSource source(data, size);
+		res.ok = parseInflated(source, res.value, &res.err, conf);
+	} else
+#endif
+	{
+		res.ok = parser.parse(data, size, res.value, &res.err);
+	}
+
+	if (!res.ok) {
+		res.error = *conf.error;
+	}
+
+	if (mapping) {
+		munmap(mapping, size);
+	}
+}
+#endif
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void serializeValue(
+		std::ostream &os, const Json::Value &v,
+		const SerializeConfig &conf, int depth) {
+	if (conf.threads == 1) {
+		serializeValue(os, v, conf, depth, nullptr);
+		return;
+	}
+
+	// One pool for the whole value, so that every big container reuses the same threads
+	ThreadPool pool(conf.threads);
+	serializeValue(os, v, conf, depth, &pool);
+}
+
+inline void serializeValue(
+		std::ostream &os, const Json::Value &v,
+		const SerializeConfig &conf, int depth, ThreadPool *pool) {
+	if (pool && (v.isObject() || v.isArray()) && v.size() >= conf.parallelThreshold) {
+		serializeParallel(os, v, conf, depth, *pool);
+	} else if (v.isObject()) {
+		serializeObject(os, v, conf, depth, pool);
+	} else if (v.isArray()) {
+		serializeArray(os, v, conf, depth, pool);
+	} else if (isRawNumber(v)) {
+		const char *begin, *end;
+		v.getString(&begin, &end);
+		os.write(begin, end - begin);
+	} else if (v.isString()) {
+		serializeStringLiteral(os, v.asCString());
+	} else if (v.type() == Json::intValue) {
+		os << (long long)v.asLargestInt();
+	} else if (v.type() == Json::uintValue) {
+		os << (unsigned long long)v.asLargestUInt();
+	} else if (v.type() == Json::realValue) {
+		// 'os << v' formats doubles the same way, but sets up
+		// a whole jsoncpp stream writer for every value
+		os << Json::valueToString(v.asDouble());
+	} else if (v.type() == Json::booleanValue) {
+		os << (v.asBool() ? "true" : "false");
+	} else {
+		os << "null";
+	}
+}
+
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool parse(
+		std::istream &is, Json::Value &v,
+		std::string *err, ParseConfig conf) {
+	detail::Reader r(is, conf);
+
+	if (conf.paths) {
+		detail::PathSelection sel;
+		detail::compilePaths(*conf.paths, sel);
+		return detail::parseDocument(r, v, err, &sel);
+	}
+
+	return detail::parseDocument(r, v, err, nullptr);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool parse(
+		const char *data, size_t size, Json::Value &v,
+		std::string *err, ParseConfig conf) {
+	detail::Reader r(conf);
+	r.reset(data, size);
+
+	if (conf.paths) {
+		detail::PathSelection sel;
+		detail::compilePaths(*conf.paths, sel);
+		return detail::parseDocument(r, v, err, &sel);
+	}
+
+	return detail::parseDocument(r, v, err, nullptr);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool reparse(
+		std::string &text, Json::Value &v,
+		size_t offset, size_t removed, const std::string &inserted,
+		std::string *err, ParseConfig conf) {
+	conf.recordOffsets = true;
+	conf.merge = false;
+	conf.sourceMap = nullptr;
+	if (offset > text.size() || removed > text.size() - offset) {
+		v = Json::nullValue;
+		detail::error(conf.error, detail::Location(), err, ERROR_INVALID_EDIT);
+		return false;
+	}
+
+	text.replace(offset, removed, inserted);
+	ptrdiff_t delta = (ptrdiff_t)inserted.size() - (ptrdiff_t)removed;
+
+	int depth = 0;
+	Json::Value *target = nullptr;
+	if (v.getOffsetLimit() > 0 && !conf.paths) {
+		target = detail::findEnclosingValue(v, offset, offset + removed, depth);
+	}
+
+	if (target) {
+		// Parse the edited value on its own. It must still be exactly one value,
+		// otherwise the edit changed the structure around it.
+		size_t start = target->getOffsetStart();
+		size_t limit = target->getOffsetLimit() + delta;
+		ParseConfig valueConf = conf;
+		valueConf.error = nullptr; // Errors here just mean a full parse is needed
+		detail::Reader r(valueConf);
+		r.reset(text.data() + start, limit - start, start);
+
+		Json::Value value;
+		bool ok;
+		if (conf.strictJson) {
+			ok = detail::parseValue<detail::JsonDialect>(r, value, nullptr, depth);
+		} else if (conf.newlinesAsCommas) {
+			ok = detail::parseValue<detail::Json5NewlinesDialect>(r, value, nullptr, depth);
+		} else {
+			ok = detail::parseValue<detail::Json5Dialect>(r, value, nullptr, depth);
+		}
+
+		if (ok && r.peek() == EOF) {
+			if (delta != 0) {
+				detail::shiftOffsets(v, offset + removed, delta, target);
+			}
+			*target = std::move(value);
+			return true;
+		}
+	}
+
+	Json::Value value;
+	if (!parse(text.data(), text.size(), value, err, conf)) {
+		v = Json::nullValue;
+		return false;
+	}
+
+	v = std::move(value);
+	return true;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool parseFile(
+		const std::string &path, Json::Value &v,
+		std::string *err, ParseConfig conf) {
+	FILE *f = fopen(path.c_str(), "rb");
+	if (!f) {
+		detail::fileError("Couldn't open", path.c_str(), err);
+		detail::ioError(conf.error);
+		return false;
+	}
+
+	std::string data;
+#ifdef JSON5CPP_ZLIB
+	// Stream compressed files, rather than reading all of them into memory.
+	// The magic is sniffed from the same open file which is then parsed,
+	// and kept rather than seeked back over, so replacing the file in between
+	// can't mix up two files, and pipes work too.
+	char magic[2];
+	size_t magicSize = fread(magic, 1, sizeof(magic), f);
+	if (detail::isGzip(magic, magicSize)) {
+		detail::InflateSource source(f, magic, magicSize);
+		bool ok = detail::parseInflated(source, v, err, conf);
+		fclose(f);
+		return ok;
+	}
+
+	data.assign(magic, magicSize);
+#endif
+
+	bool ok = detail::readFile(f, path.c_str(), data, err);
+	fclose(f);
+	if (!ok) {
+		detail::ioError(conf.error);
+		return false;
+	}
+
+	return parse(data.data(), data.size(), v, err, conf);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool validate(
+		std::istream &is,
+		std::string *err, ParseConfig conf) {
+	detail::Reader r(is, conf);
+	return detail::validateDocument(r, err);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Parser::Parser(ParseConfig conf): state_(new detail::ParserState(conf)) {}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Parser::Parser(Parser &&other) = default;
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Parser &Parser::operator=(Parser &&other) = default;
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Parser::~Parser() = default;
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool Parser::parse(std::istream &is, Json::Value &v, std::string *err) {
+	state_->reader.reset(is);
+	if (state_->reader.conf().paths) {
+		return detail::parseDocument(state_->reader, v, err, &state_->selection);
+	}
+
+	return detail::parseDocument(state_->reader, v, err, nullptr);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool Parser::parse(
+		const char *data, size_t size, Json::Value &v,
+		std::string *err) {
+	state_->reader.reset(data, size);
+	if (state_->reader.conf().paths) {
+		return detail::parseDocument(state_->reader, v, err, &state_->selection);
+	}
+
+	return detail::parseDocument(state_->reader, v, err, nullptr);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool Parser::validate(std::istream &is, std::string *err) {
+	state_->reader.reset(is);
+	return detail::validateDocument(state_->reader, err);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool Parser::validate(const char *data, size_t size, std::string *err) {
+	state_->reader.reset(data, size);
+	return detail::validateDocument(state_->reader, err);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+FileCache::FileCache(ParseConfig conf, bool hashContents):
+		state_(new detail::FileCacheState()) {
+	// Files can be parsed on many threads at once
+	conf.error = nullptr;
+	conf.sourceMap = nullptr;
+	state_->conf = conf;
+	state_->hashContents = hashContents;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+FileCache::~FileCache() = default;
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+std::shared_ptr<const Json::Value> FileCache::get(
+		const std::string &path, std::string *err) {
+	detail::FileCacheEntry entry;
+#if JSON5CPP_POSIX
+	struct stat st;
+	if (stat(path.c_str(), &st) != 0) {
+		detail::fileError("Couldn't open", path.c_str(), err);
+		return nullptr;
+	}
+
+	entry.size = st.st_size;
+	entry.mtime = st.st_mtime;
+#if defined(__APPLE__)
+	entry.mtimeNsec = st.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+	entry.mtimeNsec = st.st_mtim.tv_nsec;
+#endif
+
+	bool hash = state_->hashContents;
+#else
+	// Without stat, the size and modification time are unknown,
+	// so a file can only be recognized as unchanged by its contents
+	bool hash = true;
+#endif
+
+	std::shared_ptr<const Json::Value> cached;
+	unsigned long long cachedHash = 0;
+	{
+		std::lock_guard<std::mutex> lock(state_->mut);
+		auto it = state_->entries.find(path);
+		if (
+				it != state_->entries.end() &&
+				it->second.size == entry.size &&
+				it->second.mtime == entry.mtime &&
+				it->second.mtimeNsec == entry.mtimeNsec) {
+			if (!hash) {
+				return it->second.value;
+			}
+
+			cached = it->second.value;
+			cachedHash = it->second.hash;
+		}
+	}
+
+	// Read and parse outside of the lock,
+	// so that other files can be looked up in the meantime
+	std::string data;
+	if (!detail::readFile(path.c_str(), data, err)) {
+		return nullptr;
+	}
+
+	entry.hash = hash ? detail::hashContents(data) : 0;
+	if (cached && entry.hash == cachedHash) {
+		return cached;
+	}
+
+	std::shared_ptr<Json::Value> value = std::make_shared<Json::Value>();
+#ifdef JSON5CPP_ZLIB
+	if (detail::isGzip(data.data(), data.size())) {
+		detail::InflateSource source(data.data(), data.size());
+		if (!detail::parseInflated(source, *value, err, state_->conf)) {
+			return nullptr;
+		}
+	} else
+#endif
+	if (!parse(data.data(), data.size(), *value, err, state_->conf)) {
+		return nullptr;
+	}
+
+	entry.value = value;
+	std::lock_guard<std::mutex> lock(state_->mut);
+	state_->entries[path] = entry;
+	return value;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void FileCache::invalidate(const std::string &path) {
+	std::lock_guard<std::mutex> lock(state_->mut);
+	state_->entries.erase(path);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void FileCache::clear() {
+	std::lock_guard<std::mutex> lock(state_->mut);
+	state_->entries.clear();
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+SharedDocument::SharedDocument(ParseConfig conf):
+	state_(new detail::SharedDocumentState(conf)) {}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+SharedDocument::~SharedDocument() = default;
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+std::shared_ptr<const Json::Value> SharedDocument::get() const {
+	return state_->get();
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool SharedDocument::reload(const char *data, size_t size, std::string *err) {
+	std::shared_ptr<Json::Value> doc = std::make_shared<Json::Value>();
+	if (!parse(data, size, *doc, err, state_->conf)) {
+		return false;
+	}
+
+	state_->publish(std::move(doc));
+	return true;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool SharedDocument::reload(std::istream &is, std::string *err) {
+	std::shared_ptr<Json::Value> doc = std::make_shared<Json::Value>();
+	if (!parse(is, *doc, err, state_->conf)) {
+		return false;
+	}
+
+	state_->publish(std::move(doc));
+	return true;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool SharedDocument::reloadFile(const std::string &path, std::string *err) {
+	std::shared_ptr<Json::Value> doc = std::make_shared<Json::Value>();
+	if (!parseFile(path, *doc, err, state_->conf)) {
+		return false;
+	}
+
+	state_->publish(std::move(doc));
+	return true;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void SharedDocument::set(std::shared_ptr<const Json::Value> doc) {
+	state_->publish(std::move(doc));
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+std::vector<ParseResult> parseBatch(
+		const Buffer *docs, size_t count,
+		ParseConfig conf, unsigned int threads) {
+	std::vector<ParseResult> results(count);
+
+	// Hand out documents in chunks, so that threads which finish early
+	// pick up the remaining work, without contending on every document
+	const size_t chunk = 16;
+	threads = detail::threadCount(threads);
+	if (threads > (count + chunk - 1) / chunk) {
+		threads = (count + chunk - 1) / chunk;
+	}
+	if (threads == 0) {
+		threads = 1;
+	}
+
+	std::atomic<size_t> next(0);
+	detail::runThreads(threads, [&] {
+		// Each thread gets its own error, which is copied into the result
+		ParseError error;
+		ParseConfig threadConf = conf;
+		threadConf.error = &error;
+		threadConf.sourceMap = nullptr;
+		Parser parser(threadConf);
+		size_t begin;
+		while ((begin = next.fetch_add(chunk)) < count) {
+			size_t end = std::min(begin + chunk, count);
+			for (size_t i = begin; i < end; ++i) {
+				ParseResult &res = results[i];
+				res.ok = parser.parse(docs[i].data, docs[i].size, res.value, &res.err);
+				if (!res.ok) {
+					res.error = error;
+				}
+			}
+		}
+	});
+
+	return results;
+}
+
+#if JSON5CPP_POSIX
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+std::map<std::string, ParseResult> loadDirectory(
+		const std::string &dir, ParseConfig conf,
+		unsigned int threads, const std::string &extension) {
+	std::map<std::string, ParseResult> results;
+
+	// Keys are 'dir' joined with the relative path, without doubled slashes
+	std::string root = dir;
+	while (root.size() > 1 && root.back() == '/') {
+		root.pop_back();
+	}
+
+	std::vector<std::string> files;
+	detail::listDirectory(root, extension, files, results);
+
+	// The map can't be modified while the threads write results into it,
+	// so all entries are created up front
+	std::vector<ParseResult *> slots;
+	slots.reserve(files.size());
+	for (const std::string &path: files) {
+		slots.push_back(&results[path]);
+	}
+
+	// Like parseBatch, but in smaller chunks, since files take longer than buffers
+	const size_t chunk = 4;
+	const size_t count = files.size();
+	threads = detail::threadCount(threads);
+	if (threads > (count + chunk - 1) / chunk) {
+		threads = (count + chunk - 1) / chunk;
+	}
+	if (threads == 0) {
+		threads = 1;
+	}
+
+	std::atomic<size_t> next(0);
+	detail::runThreads(threads, [&] {
+		ParseError error;
+		ParseConfig threadConf = conf;
+		threadConf.error = &error;
+		threadConf.sourceMap = nullptr;
+		Parser parser(threadConf);
+		std::string buf;
+		size_t begin;
+		while ((begin = next.fetch_add(chunk)) < count) {
+			size_t end = std::min(begin + chunk, count);
+			for (size_t i = begin; i < end; ++i) {
+				detail::loadDirectoryFile(parser, threadConf, files[i], buf, *slots[i]);
+			}
+		}
+	});
+
+	return results;
+}
+#endif
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void serialize(
+		std::ostream &os, const Json::Value &v,
 		SerializeConfig conf, int depth) {
 	detail::serializeValue(os, v, conf, depth);
 }
 
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+const char *errorMessage(ErrorCode code) {
+	switch (code) {
+	case ERROR_NONE: return "No error";
+	case ERROR_IO: return "Couldn't read file";
+	case ERROR_UNEXPECTED_EOF: return "Unexpected EOF";
+	case ERROR_TRAILING_GARBAGE: return "Trailing garbage";
+	case ERROR_DEPTH_LIMIT: return "Depth limit reached";
+	case ERROR_INVALID_KEYWORD: return "Invalid keyword";
+	case ERROR_INVALID_NUMBER: return "Invalid number";
+	case ERROR_INVALID_IDENTIFIER_START: return "Invalid start character in identifier";
+	case ERROR_INVALID_ESCAPE: return "Invalid escape sequence";
+	case ERROR_INVALID_HEX: return "Invalid hex sequence";
+	case ERROR_EXPECTED_TRAILING_SURROGATE: return "Expected trailing surrogate";
+	case ERROR_INVALID_TRAILING_SURROGATE: return "Invalid trailing surrogate";
+	case ERROR_INVALID_UTF8: return "Invalid UTF-8";
+	case ERROR_UNESCAPED_LINE_TERMINATOR: return "Unescaped line terminator in string literal";
+	case ERROR_UNESCAPED_CONTROL_CHARACTER: return "Unescaped control character in string literal";
+	case ERROR_EXPECTED_KEY: return "Expected key";
+	case ERROR_EXPECTED_KEY_OR_BRACE: return "Expected key or '}'";
+	case ERROR_EXPECTED_STRING_KEY: return "Expected string key";
+	case ERROR_EXPECTED_COLON: return "Expected colon ':'";
+	case ERROR_EXPECTED_VALUE: return "Expected value";
+	case ERROR_EXPECTED_VALUE_OR_BRACKET: return "Expected value or ']'";
+	case ERROR_EXPECTED_COMMA_OR_BRACE: return "Expected ',' or '}'";
+	case ERROR_EXPECTED_COMMA_OR_BRACKET: return "Expected ',' or ']'";
+	case ERROR_EXPECTED_COMMA_NEWLINE_OR_BRACE: return "Expected ',', newline or '}'";
+	case ERROR_EXPECTED_COMMA_NEWLINE_OR_BRACKET: return "Expected ',', newline or ']'";
+	case ERROR_INVALID_PATHS: return "Invalid JSON pointer in paths";
+	case ERROR_INVALID_COMPRESSED_DATA: return "Invalid compressed data";
+	case ERROR_INVALID_EDIT: return "Edit is outside of the document";
+	}
+
+	return "Unknown error";
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+const SourceMap::Span *SourceMap::find(size_t offset) const {
+	// The last span which starts at or before 'offset',
+	// then its parents until one which contains 'offset'
+	auto it = std::upper_bound(
+		spans.begin(), spans.end(), offset,
+		[](size_t offset, const Span &span) { return offset < span.start; });
+	if (it == spans.begin()) {
+		return nullptr;
+	}
+
+	size_t index = it - spans.begin() - 1;
+	while (index != SIZE_MAX && (offset >= spans[index].limit || !spans[index].value)) {
+		index = spans[index].parent;
+	}
+
+	return index == SIZE_MAX ? nullptr : &spans[index];
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+const SourceMap::Span *SourceMap::find(const Json::Value &v) const {
+	// Values from a parse with a source map have their offsets recorded,
+	// and no two values start at the same offset.
+	// Raw numbers have their offsets swapped.
+	size_t start = std::min(v.getOffsetStart(), v.getOffsetLimit());
+	auto it = std::lower_bound(
+		spans.begin(), spans.end(), start,
+		[](const Span &span, size_t start) { return span.start < start; });
+	if (it == spans.end() || it->value != &v) {
+		return nullptr;
+	}
+
+	return &*it;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void SourceMap::position(size_t offset, int &line, int &column) const {
+	auto it = std::upper_bound(lines.begin(), lines.end(), offset);
+	if (it == lines.begin()) {
+		line = 1;
+		column = 1;
+		return;
+	}
+
+	line = it - lines.begin();
+	column = offset - *(it - 1) + 1;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool isRawNumber(const Json::Value &v) {
+	return v.isString() && v.getOffsetStart() > v.getOffsetLimit();
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Json::Value convertNumber(const Json::Value &v) {
+	if (!isRawNumber(v)) {
+		return v;
+	}
+
+	const char *begin, *end;
+	v.getString(&begin, &end);
+	detail::Reader r;
+	r.reset(begin, end - begin);
+
+	// The text was validated when it was parsed
+	Json::Value number;
+	detail::parseNumber<detail::Json5Dialect>(r, number, nullptr);
+	return number;
+}
+
+#ifdef JSON5CPP_ZLIB
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool parseGzip(
+		std::istream &is, Json::Value &v,
+		std::string *err, ParseConfig conf) {
+	detail::InflateSource source(is);
+	return detail::parseInflated(source, v, err, conf);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+GzipOStream::GzipOStream(std::ostream &os, int level):
+	std::ostream(nullptr), buf_(new detail::DeflateBuf(os, level)) {
+	rdbuf(buf_.get());
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+GzipOStream::~GzipOStream() {
+	finish();
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool GzipOStream::finish() {
+	if (!buf_->finish()) {
+		setstate(std::ios::badbit);
+		return false;
+	}
+
+	return true;
+}
+#endif
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Writer::Writer(std::ostream &os, SerializeConfig conf, int depth):
+	os_(os), conf_(conf), baseDepth_(depth) {}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void Writer::beginObject() {
+	beginValue();
+	os_ << '{';
+	levels_.push_back({'}', true});
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void Writer::endObject() {
+	end('}');
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void Writer::beginArray() {
+	beginValue();
+	os_ << '[';
+	levels_.push_back({']', true});
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void Writer::endArray() {
+	end(']');
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void Writer::key(const char *key) {
+	Level &level = levels_.back();
+	if (!level.first) {
+		os_ << ',';
+	}
+	level.first = false;
+
+	detail::serializeNewLine(os_, conf_, depth());
+
+	detail::serializeIdentifier(os_, key, conf_);
+	if (conf_.indent == nullptr) {
+		os_ << ":";
+	} else {
+		os_ << ": ";
+	}
+
+	afterKey_ = true;
+}
+
+// Emit whatever has to come before a value:
+// nothing at the top level or after a key, a separator in arrays
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void Writer::beginValue() {
+	if (afterKey_ || levels_.empty()) {
+		afterKey_ = false;
+		return;
+	}
+
+	Level &level = levels_.back();
+	if (!level.first) {
+		os_ << ',';
+	}
+	level.first = false;
+
+	detail::serializeNewLine(os_, conf_, depth());
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void Writer::end(char close) {
+	bool first = levels_.back().first;
+	levels_.pop_back();
+
+	if (!first) {
+		if (conf_.trailingCommas) {
+			os_ << ',';
+		}
+
+		detail::serializeNewLine(os_, conf_, depth());
+	}
+
+	os_ << close;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+uint32_t SnapshotValue::readU32(size_t at) const {
+	uint32_t x;
+	memcpy(&x, data_ + offset_ + at, sizeof(x));
+	return x;
+}
+
+// The value's tag, or SNAPSHOT_NULL if the value doesn't fit in the snapshot
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+unsigned char SnapshotValue::tag() const {
+	if (!has(1)) {
+		return detail::SNAPSHOT_NULL;
+	}
+
+	unsigned char tag = data_[offset_];
+	bool fits = false;
+	switch (tag) {
+	case detail::SNAPSHOT_NULL:
+	case detail::SNAPSHOT_FALSE:
+	case detail::SNAPSHOT_TRUE:
+		fits = true;
+		break;
+
+	case detail::SNAPSHOT_INT:
+	case detail::SNAPSHOT_UINT:
+	case detail::SNAPSHOT_REAL:
+		fits = has(9);
+		break;
+
+	case detail::SNAPSHOT_STRING:
+		fits = has(5) && has(5 + (uint64_t)readU32(1) + 1);
+		break;
+
+	case detail::SNAPSHOT_ARRAY:
+		fits = has(5) && has(5 + (uint64_t)readU32(1) * 4);
+		break;
+
+	case detail::SNAPSHOT_OBJECT:
+		fits = has(5) && has(5 + (uint64_t)readU32(1) * 8);
+		break;
+	}
+
+	return fits ? tag : (unsigned char)detail::SNAPSHOT_NULL;
+}
+
+// Children always come before their parent,
+// which also keeps a corrupt snapshot from sending toValue in circles
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+SnapshotValue SnapshotValue::child(uint32_t offset) const {
+	if (offset >= offset_) {
+		return SnapshotValue();
+	}
+
+	return SnapshotValue(data_, size_, offset);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Json::ValueType SnapshotValue::type() const {
+	switch (tag()) {
+	case detail::SNAPSHOT_FALSE:
+	case detail::SNAPSHOT_TRUE:
+		return Json::booleanValue;
+	case detail::SNAPSHOT_INT:
+		return Json::intValue;
+	case detail::SNAPSHOT_UINT:
+		return Json::uintValue;
+	case detail::SNAPSHOT_REAL:
+		return Json::realValue;
+	case detail::SNAPSHOT_STRING:
+		return Json::stringValue;
+	case detail::SNAPSHOT_ARRAY:
+		return Json::arrayValue;
+	case detail::SNAPSHOT_OBJECT:
+		return Json::objectValue;
+	}
+
+	return Json::nullValue;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool SnapshotValue::asBool() const {
+	switch (tag()) {
+	case detail::SNAPSHOT_TRUE:
+		return true;
+	case detail::SNAPSHOT_INT:
+	case detail::SNAPSHOT_UINT:
+	case detail::SNAPSHOT_REAL:
+		return asDouble() != 0;
+	}
+
+	return false;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Json::Int64 SnapshotValue::asInt64() const {
+	switch (tag()) {
+	case detail::SNAPSHOT_TRUE:
+		return 1;
+	case detail::SNAPSHOT_INT: {
+		int64_t x;
+		memcpy(&x, data_ + offset_ + 1, sizeof(x));
+		return x;
+	}
+	case detail::SNAPSHOT_UINT: {
+		Json::UInt64 x = asUInt64();
+		return x > (Json::UInt64)std::numeric_limits<Json::Int64>::max() ?
+			std::numeric_limits<Json::Int64>::max() : (Json::Int64)x;
+	}
+	case detail::SNAPSHOT_REAL: {
+		// Converting a double which doesn't fit is undefined behavior;
+		// -2^63 is exact as a double, and so is 2^63 just past the maximum
+		double x = asDouble();
+		if (x != x) {
+			return 0;
+		} else if (x < -9223372036854775808.0) {
+			return std::numeric_limits<Json::Int64>::min();
+		} else if (x >= 9223372036854775808.0) {
+			return std::numeric_limits<Json::Int64>::max();
+		}
+		return (Json::Int64)x;
+	}
+	}
+
+	return 0;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Json::UInt64 SnapshotValue::asUInt64() const {
+	switch (tag()) {
+	case detail::SNAPSHOT_TRUE:
+		return 1;
+	case detail::SNAPSHOT_INT: {
+		Json::Int64 x = asInt64();
+		return x < 0 ? 0 : (Json::UInt64)x;
+	}
+	case detail::SNAPSHOT_UINT: {
+		uint64_t x;
+		memcpy(&x, data_ + offset_ + 1, sizeof(x));
+		return x;
+	}
+	case detail::SNAPSHOT_REAL: {
+		double x = asDouble();
+		if (x != x || x <= -1.0) {
+			return 0;
+		} else if (x >= 18446744073709551616.0) {
+			return std::numeric_limits<Json::UInt64>::max();
+		}
+		return (Json::UInt64)x;
+	}
+	}
+
+	return 0;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+double SnapshotValue::asDouble() const {
+	switch (tag()) {
+	case detail::SNAPSHOT_TRUE:
+		return 1;
+	case detail::SNAPSHOT_INT:
+		return (double)asInt64();
+	case detail::SNAPSHOT_UINT:
+		return (double)asUInt64();
+	case detail::SNAPSHOT_REAL: {
+		double x;
+		memcpy(&x, data_ + offset_ + 1, sizeof(x));
+		return x;
+	}
+	}
+
+	return 0;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+const char *SnapshotValue::asCString() const {
+	if (tag() != detail::SNAPSHOT_STRING) {
+		return "";
+	}
+
+	return (const char *)data_ + offset_ + 5;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool SnapshotValue::getString(const char **begin, const char **end) const {
+	if (tag() != detail::SNAPSHOT_STRING) {
+		return false;
+	}
+
+	*begin = (const char *)data_ + offset_ + 5;
+	*end = *begin + readU32(1);
+	return true;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Json::ArrayIndex SnapshotValue::size() const {
+	unsigned char tag = this->tag();
+	if (tag != detail::SNAPSHOT_ARRAY && tag != detail::SNAPSHOT_OBJECT) {
+		return 0;
+	}
+
+	return readU32(1);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+SnapshotValue SnapshotValue::operator[](Json::ArrayIndex index) const {
+	unsigned char tag = this->tag();
+	if (tag == detail::SNAPSHOT_ARRAY && index < readU32(1)) {
+		return child(readU32(5 + (size_t)index * 4));
+	} else if (tag == detail::SNAPSHOT_OBJECT && index < readU32(1)) {
+		return child(readU32(5 + (size_t)index * 8 + 4));
+	}
+
+	return SnapshotValue();
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+const char *SnapshotValue::key(Json::ArrayIndex index) const {
+	if (tag() != detail::SNAPSHOT_OBJECT || index >= readU32(1)) {
+		return "";
+	}
+
+	return child(readU32(5 + (size_t)index * 8)).asCString();
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+SnapshotValue SnapshotValue::operator[](const char *key) const {
+	return find(key, key + strlen(key));
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+SnapshotValue SnapshotValue::operator[](const std::string &key) const {
+	return find(key.data(), key.data() + key.size());
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+SnapshotValue SnapshotValue::find(const char *begin, const char *end) const {
+	if (tag() != detail::SNAPSHOT_OBJECT) {
+		return SnapshotValue();
+	}
+
+	size_t length = end - begin;
+	Json::ArrayIndex lo = 0;
+	Json::ArrayIndex hi = readU32(1);
+	while (lo < hi) {
+		Json::ArrayIndex mid = lo + (hi - lo) / 2;
+		const char *keyBegin = "", *keyEnd = keyBegin;
+		child(readU32(5 + (size_t)mid * 8)).getString(&keyBegin, &keyEnd);
+
+		size_t keyLength = keyEnd - keyBegin;
+		int cmp = memcmp(keyBegin, begin, std::min(keyLength, length));
+		if (cmp == 0) {
+			cmp = keyLength < length ? -1 : keyLength > length ? 1 : 0;
+		}
+
+		if (cmp < 0) {
+			lo = mid + 1;
+		} else if (cmp > 0) {
+			hi = mid;
+		} else {
+			return child(readU32(5 + (size_t)mid * 8 + 4));
+		}
+	}
+
+	return SnapshotValue();
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Json::Value SnapshotValue::toValue() const {
+	return toValue(0);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Json::Value SnapshotValue::toValue(int depth) const {
+	switch (tag()) {
+	case detail::SNAPSHOT_FALSE:
+		return false;
+	case detail::SNAPSHOT_TRUE:
+		return true;
+	case detail::SNAPSHOT_INT:
+		return asInt64();
+	case detail::SNAPSHOT_UINT:
+		return asUInt64();
+	case detail::SNAPSHOT_REAL:
+		return asDouble();
+
+	case detail::SNAPSHOT_STRING: {
+		const char *begin, *end;
+		getString(&begin, &end);
+		return Json::Value(begin, end);
+	}
+
+	case detail::SNAPSHOT_ARRAY: {
+		if (depth >= detail::SNAPSHOT_MAX_DEPTH) {
+			return Json::Value();
+		}
+
+		Json::Value v(Json::arrayValue);
+		Json::ArrayIndex count = size();
+		v.resize(count);
+		for (Json::ArrayIndex i = 0; i < count; ++i) {
+			v[i] = (*this)[i].toValue(depth + 1);
+		}
+
+		return v;
+	}
+
+	case detail::SNAPSHOT_OBJECT: {
+		if (depth >= detail::SNAPSHOT_MAX_DEPTH) {
+			return Json::Value();
+		}
+
+		Json::Value v(Json::objectValue);
+		Json::ArrayIndex count = size();
+		for (Json::ArrayIndex i = 0; i < count; ++i) {
+			const char *begin = "", *end = begin;
+			child(readU32(5 + (size_t)i * 8)).getString(&begin, &end);
+			v[std::string(begin, end)] = (*this)[i].toValue(depth + 1);
+		}
+
+		return v;
+	}
+	}
+
+	return Json::Value();
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Snapshot::Snapshot(const void *data, size_t size) {
+	size_t snapshotSize = detail::snapshotSize(data, size);
+	if (snapshotSize > 0) {
+		data_ = (const unsigned char *)data;
+		size_ = snapshotSize;
+	}
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Snapshot::Snapshot(Snapshot &&other) {
+	*this = std::move(other);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Snapshot &Snapshot::operator=(Snapshot &&other) {
+	if (this != &other) {
+		close();
+		data_ = other.data_;
+		size_ = other.size_;
+		mapping_ = other.mapping_;
+		mappingSize_ = other.mappingSize_;
+		other.data_ = nullptr;
+		other.size_ = 0;
+		other.mapping_ = nullptr;
+		other.mappingSize_ = 0;
+	}
+
+	return *this;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+Snapshot::~Snapshot() {
+	close();
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+void Snapshot::close() {
+	if (mapping_) {
+#if JSON5CPP_POSIX
+		munmap(mapping_, mappingSize_);
+#else
+		delete[] (unsigned char *)mapping_;
+#endif
+	}
+
+	data_ = nullptr;
+	size_ = 0;
+	mapping_ = nullptr;
+	mappingSize_ = 0;
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool Snapshot::openFile(const std::string &path, std::string *err) {
+	close();
+
+#if JSON5CPP_POSIX
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		detail::fileError("Couldn't open", path.c_str(), err);
+		return false;
+	}
+
+	struct stat st;
+	void *mapping = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+
+	::close(fd);
+	if (mapping == MAP_FAILED) {
+		detail::fileError("Couldn't read", path.c_str(), err);
+		return false;
+	}
+
+	size_t snapshotSize = detail::snapshotSize(mapping, st.st_size);
+	if (snapshotSize == 0) {
+		munmap(mapping, st.st_size);
+		detail::fileError("Invalid snapshot", path.c_str(), err);
+		return false;
+	}
+
+	data_ = (const unsigned char *)mapping;
+	size_ = snapshotSize;
+	mapping_ = mapping;
+	mappingSize_ = st.st_size;
+	return true;
+#else
+	std::string data;
+	if (!detail::readFile(path.c_str(), data, err)) {
+		return false;
+	}
+
+	size_t snapshotSize = detail::snapshotSize(data.data(), data.size());
+	if (snapshotSize == 0) {
+		detail::fileError("Invalid snapshot", path.c_str(), err);
+		return false;
+	}
+
+	unsigned char *copy = new unsigned char[snapshotSize];
+	memcpy(copy, data.data(), snapshotSize);
+	data_ = copy;
+	size_ = snapshotSize;
+	mapping_ = copy;
+	mappingSize_ = snapshotSize;
+	return true;
+#endif
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+SnapshotValue Snapshot::root() const {
+	if (!data_) {
+		return SnapshotValue();
+	}
+
+	uint32_t root;
+	memcpy(&root, data_ + 8, sizeof(root));
+	return SnapshotValue(data_, size_, root);
+}
+
+#ifndef JSON5CPP_IMPL
+inline
+#endif
+bool writeSnapshot(std::ostream &os, const Json::Value &v, std::string *err) {
+	detail::SnapshotBuilder builder;
+	builder.out.resize(detail::SNAPSHOT_HEADER_SIZE);
+	uint32_t root = builder.add(v, 0);
+	if (builder.out.size() > std::numeric_limits<uint32_t>::max()) {
+		if (err) {
+			*err = "Snapshot is too big";
+		}
+		return false;
+	}
+
+	if (builder.tooDeep) {
+		if (err) {
+			*err = "Snapshot is too deep";
+		}
+		return false;
+	}
+
+	uint32_t header[4] = {
+		0, detail::SNAPSHOT_VERSION, root, (uint32_t)builder.out.size()};
+	memcpy(header, "J5SN", 4);
+	memcpy(&builder.out[0], header, sizeof(header));
+
+	if (!os.write(builder.out.data(), builder.out.size())) {
+		if (err) {
+			*err = "Couldn't write snapshot";
+		}
+		return false;
+	}
+
+	return true;
+}
+
 #endif // JSON5CPP_FWD_ONLY
 
 }
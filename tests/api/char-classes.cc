@@ -0,0 +1,94 @@
+#include "test.h"
+
+// The lexer classifies characters through a table;
+// these check every ASCII character against the JSON5 grammar.
+
+static bool isIdentifierPart(int ch) {
+	// Escapes in identifiers aren't decoded, so '\\' is kept as is
+	return
+		(ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+		(ch >= '0' && ch <= '9') || ch == '_' || ch == '$' || ch == '\\';
+}
+
+static bool isWhitespace(int ch) {
+	return ch == '\t' || ch == '\n' || ch == '\v' || ch == '\f' || ch == '\r' || ch == ' ';
+}
+
+static std::string describe(int ch) {
+	return "character " + std::to_string(ch);
+}
+
+TEST(charClassesIdentifiers) {
+	for (int ch = 1; ch < 128; ++ch) {
+		std::string doc = std::string("{a") + (char)ch + ": 1}";
+		Json::Value v;
+		bool ok = Json5::parse(doc.data(), doc.size(), v);
+		if (isIdentifierPart(ch)) {
+			if (!ok || !v.isMember(std::string("a") + (char)ch)) {
+				checkFailed(__FILE__, __LINE__, describe(ch) + " isn't part of an identifier");
+			}
+		} else if (isWhitespace(ch)) {
+			if (!ok || !v.isMember("a")) {
+				checkFailed(__FILE__, __LINE__, describe(ch) + " isn't whitespace");
+			}
+		} else if (ok) {
+			checkFailed(__FILE__, __LINE__, describe(ch) + " was accepted in an identifier");
+		}
+	}
+}
+
+TEST(charClassesNumbers) {
+	for (int ch = 1; ch < 128; ++ch) {
+		std::string doc = std::string("[1") + (char)ch + "]";
+		Json::Value v;
+		bool ok = Json5::parse(doc.data(), doc.size(), v);
+		if (ch >= '0' && ch <= '9') {
+			CHECK(ok && v[0].asInt() == 10 + ch - '0');
+		} else if (isWhitespace(ch) || ch == ',' || ch == '.') {
+			CHECK(ok && v[0].asDouble() == 1);
+		} else if (ok) {
+			checkFailed(__FILE__, __LINE__, describe(ch) + " was accepted after a number");
+		}
+	}
+}
+
+TEST(charClassesKeywords) {
+	// Keywords must end at a delimiter
+	for (int ch = 1; ch < 128; ++ch) {
+		std::string doc = std::string("[true") + (char)ch + "]";
+		Json::Value v;
+		bool ok = Json5::parse(doc.data(), doc.size(), v);
+		bool expected = isWhitespace(ch) || ch == ',';
+		if (ok != expected) {
+			checkFailed(__FILE__, __LINE__, describe(ch) + " after a keyword");
+		}
+	}
+}
+
+TEST(charClassesStrings) {
+	// Line terminators must be escaped, everything else is literal;
+	// strict JSON also requires other control characters to be escaped
+	Json5::ParseConfig strict;
+	strict.strictJson = true;
+	for (int ch = 1; ch < 128; ++ch) {
+		if (ch == '"' || ch == '\\') {
+			continue;
+		}
+
+		std::string doc = std::string("\"") + (char)ch + "\"";
+		Json::Value v;
+		bool ok = Json5::parse(doc.data(), doc.size(), v);
+		if (ch == '\n' || ch == '\r') {
+			if (ok) {
+				checkFailed(__FILE__, __LINE__, describe(ch) + " was accepted in a string");
+			}
+		} else if (!ok || v.asString() != std::string(1, (char)ch)) {
+			checkFailed(__FILE__, __LINE__, describe(ch) + " wasn't accepted in a string");
+		}
+
+		ok = Json5::parse(doc.data(), doc.size(), v, nullptr, strict);
+		if (ok != (ch >= 0x20)) {
+			checkFailed(__FILE__, __LINE__, describe(ch) + " in a strict JSON string");
+		}
+	}
+}
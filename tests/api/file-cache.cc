@@ -0,0 +1,98 @@
+#include "test.h"
+
+TEST(parseFile) {
+	std::string dir = tempDir();
+	writeFile(dir + "/a.json5", "{a: [1, 2], /* comment */ b: 'x'}");
+
+	Json::Value v;
+	std::string err;
+	CHECK(Json5::parseFile(dir + "/a.json5", v, &err));
+	CHECK_EQ(toJson(v), "{\"a\":[1,2],\"b\":\"x\"}");
+
+	Json5::ParseError error;
+	Json5::ParseConfig conf;
+	conf.error = &error;
+	CHECK(!Json5::parseFile(dir + "/missing.json5", v, &err, conf));
+	CHECK(err.find("Couldn't open") != std::string::npos);
+	CHECK(err.find("missing.json5") != std::string::npos);
+	CHECK_EQ(error.code, Json5::ERROR_IO);
+
+	writeFile(dir + "/bad.json5", "{a: }");
+	CHECK(!Json5::parseFile(dir + "/bad.json5", v, &err, conf));
+	CHECK_EQ(err, "1:5: Invalid start character in identifier");
+}
+
+TEST(fileCacheReusesUnchanged) {
+	std::string dir = tempDir();
+	std::string path = dir + "/config.json5";
+	writeFile(path, "{a: 1}");
+
+	Json5::FileCache cache;
+	std::shared_ptr<const Json::Value> first = cache.get(path);
+	CHECK(first != nullptr);
+	std::shared_ptr<const Json::Value> second = cache.get(path);
+	CHECK(first == second);
+	CHECK_EQ(toJson(*second), "{\"a\":1}");
+
+	// A changed size is always noticed
+	writeFile(path, "{a: 1234}");
+	std::shared_ptr<const Json::Value> third = cache.get(path);
+	CHECK(third != nullptr && third != first);
+	CHECK_EQ(toJson(*third), "{\"a\":1234}");
+
+	// The old value stays valid
+	CHECK_EQ(toJson(*first), "{\"a\":1}");
+}
+
+TEST(fileCacheHashContents) {
+	std::string dir = tempDir();
+	std::string path = dir + "/config.json5";
+	writeFile(path, "{a: 1}");
+
+	Json5::FileCache cache({}, true);
+	std::shared_ptr<const Json::Value> first = cache.get(path);
+	CHECK(first != nullptr);
+	CHECK(cache.get(path) == first);
+
+	// Same size, possibly the same modification time; only the hash can tell
+	writeFile(path, "{a: 2}");
+	std::shared_ptr<const Json::Value> second = cache.get(path);
+	CHECK(second != nullptr);
+	CHECK_EQ(toJson(*second), "{\"a\":2}");
+}
+
+TEST(fileCacheInvalidate) {
+	std::string dir = tempDir();
+	std::string path = dir + "/config.json5";
+	writeFile(path, "[1]");
+
+	Json5::FileCache cache;
+	std::shared_ptr<const Json::Value> first = cache.get(path);
+	cache.invalidate(path);
+	std::shared_ptr<const Json::Value> second = cache.get(path);
+	CHECK(first != second);
+	cache.clear();
+	CHECK(cache.get(path) != second);
+}
+
+TEST(fileCacheErrors) {
+	std::string dir = tempDir();
+	std::string path = dir + "/config.json5";
+
+	Json5::ParseConfig conf;
+	conf.strictJson = true;
+	Json5::FileCache cache(conf);
+	std::string err;
+	CHECK(cache.get(path, &err) == nullptr);
+	CHECK(err.find("Couldn't open") != std::string::npos);
+
+	writeFile(path, "{a: 1}");
+	CHECK(cache.get(path, &err) == nullptr);
+	CHECK_EQ(err, "1:2: Expected string key");
+
+	// A failed parse isn't cached
+	writeFile(path, "{\"a\": 10}");
+	std::shared_ptr<const Json::Value> v = cache.get(path, &err);
+	CHECK(v != nullptr);
+	CHECK_EQ(toJson(*v), "{\"a\":10}");
+}
@@ -0,0 +1,169 @@
+#include "test.h"
+
+#include <zlib.h>
+
+#if JSON5CPP_POSIX
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#endif
+
+static std::string gzip(const std::string &data, int level = -1) {
+	std::ostringstream os;
+	Json5::GzipOStream gz(os, level);
+	gz << data;
+	CHECK(gz.finish());
+	return os.str();
+}
+
+static std::string bigDocument() {
+	std::string doc = "{items: [";
+	for (int i = 0; i < 20000; ++i) {
+		doc += "{id: " + std::to_string(i) + ", name: 'item number " + std::to_string(i) + "'},\n";
+	}
+	doc += "]}";
+	return doc;
+}
+
+static Json::Value parseGzipOk(const std::string &data, Json5::ParseConfig conf = {}) {
+	std::istringstream is(data);
+	Json::Value v;
+	std::string err;
+	if (!Json5::parseGzip(is, v, &err, conf)) {
+		checkFailed(__FILE__, __LINE__, "parseGzip failed: " + err);
+	}
+
+	return v;
+}
+
+TEST(gzipRoundTrip) {
+	std::string doc = bigDocument();
+	std::string compressed = gzip(doc);
+	CHECK(compressed.size() < doc.size() / 4);
+	CHECK_EQ(compressed.substr(0, 2), "\x1f\x8b");
+	CHECK_EQ(toJson(parseGzipOk(compressed)), toJson(parseOk(doc)));
+
+	// Every level gives a valid stream
+	for (int level: {0, 1, 9}) {
+		CHECK_EQ(toJson(parseGzipOk(gzip("[1, 'two']", level))), "[1,\"two\"]");
+	}
+}
+
+TEST(gzipSerialize) {
+	Json::Value v = parseOk(bigDocument());
+	std::ostringstream os;
+	{
+		Json5::GzipOStream gz(os);
+		Json5::serialize(gz, v);
+		// The destructor finishes the stream
+	}
+
+	CHECK_EQ(toJson(parseGzipOk(os.str())), toJson(v));
+}
+
+TEST(gzipZlibAndConcatenated) {
+	std::string doc = "{a: [1, 2, 3]}";
+	uLongf size = compressBound(doc.size());
+	std::string zlib(size, '\0');
+	CHECK_EQ(compress((Bytef *)&zlib[0], &size, (const Bytef *)doc.data(), doc.size()), Z_OK);
+	zlib.resize(size);
+	CHECK_EQ(toJson(parseGzipOk(zlib)), "{\"a\":[1,2,3]}");
+
+	std::string concatenated = gzip("{a: [1, ") + gzip("2, 3]}");
+	CHECK_EQ(toJson(parseGzipOk(concatenated)), "{\"a\":[1,2,3]}");
+}
+
+TEST(gzipErrors) {
+	Json5::ParseConfig conf;
+	Json5::ParseError error;
+	conf.error = &error;
+	Json::Value v;
+
+	// Corrupt data; the garbage may also be noticed by the parser first
+	std::string compressed = gzip(bigDocument());
+	compressed[compressed.size() / 2] ^= 0x55;
+	std::istringstream corrupt(compressed);
+	CHECK(!Json5::parseGzip(corrupt, v, nullptr, conf));
+	CHECK(error.code != Json5::ERROR_NONE);
+
+	// A corrupt checksum is only noticed at the end
+	compressed = gzip("[1, 2, 3]");
+	compressed[compressed.size() - 6] ^= 0x55;
+	std::istringstream checksum(compressed);
+	CHECK(!Json5::parseGzip(checksum, v, nullptr, conf));
+	CHECK_EQ(error.code, Json5::ERROR_INVALID_COMPRESSED_DATA);
+
+	// Truncated data
+	compressed = gzip("[1, 2, 3]");
+	std::istringstream truncated(compressed.substr(0, compressed.size() - 12));
+	CHECK(!Json5::parseGzip(truncated, v, nullptr, conf));
+
+	// Not compressed at all
+	std::istringstream plain("[1, 2, 3]");
+	CHECK(!Json5::parseGzip(plain, v, nullptr, conf));
+	CHECK_EQ(error.code, Json5::ERROR_INVALID_COMPRESSED_DATA);
+
+	// Compressed, but not a valid document
+	std::istringstream invalid(gzip("[1, 2"));
+	std::string err;
+	CHECK(!Json5::parseGzip(invalid, v, &err, conf));
+	CHECK_EQ(err, "1:6: Unexpected EOF");
+}
+
+TEST(gzipFiles) {
+	std::string dir = tempDir();
+	std::string doc = bigDocument();
+	writeFile(dir + "/doc.json5.gz", gzip(doc));
+	writeFile(dir + "/doc.json5", doc);
+
+	Json::Value v;
+	CHECK(Json5::parseFile(dir + "/doc.json5.gz", v));
+	std::string expected = toJson(parseOk(doc));
+	CHECK_EQ(toJson(v), expected);
+
+	Json5::FileCache cache;
+	std::shared_ptr<const Json::Value> cached = cache.get(dir + "/doc.json5.gz");
+	CHECK(cached != nullptr);
+	CHECK_EQ(toJson(*cached), expected);
+	cached = cache.get(dir + "/doc.json5");
+	CHECK(cached != nullptr);
+	CHECK_EQ(toJson(*cached), expected);
+}
+
+TEST(gzipFilesShort) {
+	// Files too short to hold the magic are still read in full
+	std::string dir = tempDir();
+	writeFile(dir + "/one.json5", "1");
+	writeFile(dir + "/magic.json5", "\x1f");
+	writeFile(dir + "/empty.json5", "");
+
+	Json::Value v;
+	CHECK(Json5::parseFile(dir + "/one.json5", v));
+	CHECK_EQ(v.asInt(), 1);
+	std::string err;
+	CHECK(!Json5::parseFile(dir + "/magic.json5", v, &err));
+	CHECK_EQ(err, "1:1: Invalid start character in identifier");
+	CHECK(!Json5::parseFile(dir + "/empty.json5", v, &err));
+	CHECK_EQ(err, "1:1: Unexpected EOF");
+}
+
+#if JSON5CPP_POSIX
+TEST(gzipFilesPipe) {
+	// The magic isn't seeked back over, so pipes work for both kinds of input
+	std::string dir = tempDir();
+	std::string doc = bigDocument();
+	std::string expected = toJson(parseOk(doc));
+	for (const std::string &data: {gzip(doc), doc}) {
+		std::string path = dir + "/pipe";
+		unlink(path.c_str());
+		CHECK_EQ(mkfifo(path.c_str(), 0600), 0);
+		std::thread writer([&] { writeFile(path, data); });
+		Json::Value v;
+		std::string err;
+		CHECK(Json5::parseFile(path, v, &err));
+		writer.join();
+		CHECK_EQ(err, "");
+		CHECK_EQ(toJson(v), expected);
+	}
+}
+#endif
@@ -0,0 +1,4 @@
+// Contains the implementations for Json5Cpp's functions,
+// so that the test files can use JSON5CPP_FWD_ONLY.
+#define JSON5CPP_IMPL
+#include "json5cpp.h" // IWYU pragma: keep
@@ -0,0 +1,136 @@
+#include "test.h"
+
+#if JSON5CPP_POSIX
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string keysOf(const std::map<std::string, Json5::ParseResult> &results, const std::string &dir) {
+	std::string keys;
+	for (const auto &entry: results) {
+		keys += entry.first.substr(dir.size()) + (entry.second.ok ? " " : "! ");
+	}
+
+	return keys;
+}
+
+TEST(loadDirectoryTree) {
+	std::string dir = tempDir();
+	mkdir((dir + "/sub").c_str(), 0755);
+	mkdir((dir + "/sub/deeper").c_str(), 0755);
+	mkdir((dir + "/.hidden").c_str(), 0755);
+	writeFile(dir + "/a.json5", "{a: 1}");
+	writeFile(dir + "/b.json", "[1, 2,]");
+	writeFile(dir + "/.secret.json5", "{}");
+	writeFile(dir + "/sub/c.json5", "'c'");
+	writeFile(dir + "/sub/deeper/d.json5", "{d: {e: null}}");
+	writeFile(dir + "/.hidden/e.json5", "{}");
+
+	std::map<std::string, Json5::ParseResult> results = Json5::loadDirectory(dir);
+	CHECK_EQ(keysOf(results, dir), "/a.json5 /b.json /sub/c.json5 /sub/deeper/d.json5 ");
+	CHECK_EQ(toJson(results[dir + "/a.json5"].value), "{\"a\":1}");
+	CHECK_EQ(toJson(results[dir + "/b.json"].value), "[1,2]");
+	CHECK_EQ(toJson(results[dir + "/sub/c.json5"].value), "\"c\"");
+	CHECK_EQ(toJson(results[dir + "/sub/deeper/d.json5"].value), "{\"d\":{\"e\":null}}");
+
+	// Trailing slashes don't end up in the keys
+	CHECK_EQ(keysOf(Json5::loadDirectory(dir + "//"), dir), keysOf(results, dir));
+}
+
+TEST(loadDirectoryExtension) {
+	std::string dir = tempDir();
+	mkdir((dir + "/sub.json5").c_str(), 0755);
+	writeFile(dir + "/a.json5", "1");
+	writeFile(dir + "/b.json", "2");
+	writeFile(dir + "/json5", "3");
+	writeFile(dir + "/sub.json5/c.json5", "4");
+	writeFile(dir + "/sub.json5/c.txt", "5");
+
+	CHECK_EQ(keysOf(Json5::loadDirectory(dir, {}, 1, ".json5"), dir), "/a.json5 /sub.json5/c.json5 ");
+	CHECK_EQ(keysOf(Json5::loadDirectory(dir, {}, 1, ".json"), dir), "/b.json ");
+}
+
+TEST(loadDirectorySymlinks) {
+	std::string dir = tempDir();
+	std::string other = tempDir();
+	mkdir((dir + "/sub").c_str(), 0755);
+	writeFile(dir + "/sub/a.json5", "1");
+	writeFile(other + "/b.json5", "2");
+	CHECK_EQ(symlink((other + "/b.json5").c_str(), (dir + "/link.json5").c_str()), 0);
+	CHECK_EQ(symlink(other.c_str(), (dir + "/linkdir").c_str()), 0);
+	CHECK_EQ(symlink(dir.c_str(), (dir + "/sub/loop").c_str()), 0);
+	CHECK_EQ(symlink((other + "/missing").c_str(), (dir + "/dangling.json5").c_str()), 0);
+
+	// Symlinks to files are followed, symlinks to directories (and dangling ones) aren't
+	std::map<std::string, Json5::ParseResult> results;
+	finishesWithin(5, "loadDirectory with a symlink loop", [&] { results = Json5::loadDirectory(dir); });
+	CHECK_EQ(keysOf(results, dir), "/link.json5 /sub/a.json5 ");
+	CHECK_EQ(results[dir + "/link.json5"].value.asInt(), 2);
+}
+
+TEST(loadDirectoryErrors) {
+	std::string dir = tempDir();
+	writeFile(dir + "/good.json5", "{a: 1}");
+	writeFile(dir + "/bad.json5", "{a: }");
+	writeFile(dir + "/json.json5", "{\"a\": 1}");
+
+	std::map<std::string, Json5::ParseResult> results = Json5::loadDirectory(dir);
+	CHECK_EQ(keysOf(results, dir), "/bad.json5! /good.json5 /json.json5 ");
+	const Json5::ParseResult &bad = results[dir + "/bad.json5"];
+	CHECK_EQ(bad.err, "1:5: Invalid start character in identifier");
+	CHECK_EQ(bad.error.code, Json5::ERROR_INVALID_IDENTIFIER_START);
+	CHECK_EQ(bad.error.line, 1);
+	CHECK_EQ(bad.error.column, 5);
+
+	// The config applies to every file
+	Json5::ParseConfig conf;
+	conf.strictJson = true;
+	results = Json5::loadDirectory(dir, conf);
+	CHECK_EQ(keysOf(results, dir), "/bad.json5! /good.json5! /json.json5 ");
+	CHECK_EQ(results[dir + "/good.json5"].err, "1:2: Expected string key");
+
+	// A directory which can't be listed gets a result of its own
+	results = Json5::loadDirectory(dir + "/missing");
+	CHECK_EQ(results.size(), 1u);
+	const Json5::ParseResult &missing = results[dir + "/missing"];
+	CHECK(!missing.ok);
+	CHECK_EQ(missing.error.code, Json5::ERROR_IO);
+	CHECK(missing.err.find("Couldn't open") != std::string::npos);
+}
+
+TEST(loadDirectoryThreads) {
+	std::string dir = tempDir();
+	for (int i = 0; i < 50; ++i) {
+		std::string name = dir + "/" + std::to_string(i) + ".json5";
+		writeFile(name, i % 7 == 0 ? "[" : "{n: " + std::to_string(i) + "}");
+	}
+
+	// A file big enough to be mapped rather than read
+	std::string big = "[";
+	while (big.size() < 2 * 1024 * 1024) {
+		big += "'padding padding padding padding', ";
+	}
+	big += "1]";
+	writeFile(dir + "/big.json5", big);
+
+	for (unsigned int threads: {0u, 1u, 3u, 64u}) {
+		std::map<std::string, Json5::ParseResult> results = Json5::loadDirectory(dir, {}, threads);
+		CHECK_EQ(results.size(), 51u);
+		for (int i = 0; i < 50; ++i) {
+			const Json5::ParseResult &res = results[dir + "/" + std::to_string(i) + ".json5"];
+			if (i % 7 == 0) {
+				CHECK(!res.ok);
+				CHECK_EQ(res.err, "1:2: Unexpected EOF");
+			} else {
+				CHECK(res.ok);
+				CHECK_EQ(res.value["n"].asInt(), i);
+			}
+		}
+
+		const Json5::ParseResult &res = results[dir + "/big.json5"];
+		CHECK(res.ok);
+		CHECK_EQ(res.value[res.value.size() - 1].asInt(), 1);
+	}
+
+	CHECK(Json5::loadDirectory(tempDir()).empty());
+}
+#endif
@@ -0,0 +1,128 @@
+#include "test.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <stdlib.h>
+#include <string.h>
+
+std::vector<TestCase> &testCases() {
+	static std::vector<TestCase> cases;
+	return cases;
+}
+
+static int numFailures = 0;
+
+void checkFailed(const char *file, int line, const std::string &what) {
+	std::cout << "\n  " << file << ':' << line << ": Check failed: " << what;
+	numFailures += 1;
+}
+
+Json::Value parseOk(const std::string &doc, Json5::ParseConfig conf) {
+	Json::Value v;
+	std::string err;
+	if (!Json5::parse(doc.data(), doc.size(), v, &err, conf)) {
+		checkFailed(__FILE__, __LINE__, "Parsing '" + doc + "' failed: " + err);
+	}
+
+	return v;
+}
+
+std::string parseErr(const std::string &doc, Json5::ParseConfig conf) {
+	Json::Value v;
+	std::string err;
+	if (Json5::parse(doc.data(), doc.size(), v, &err, conf)) {
+		checkFailed(__FILE__, __LINE__, "Parsing '" + doc + "' unexpectedly succeeded");
+	}
+
+	return err;
+}
+
+std::string toJson(const Json::Value &v) {
+	Json5::SerializeConfig conf;
+	conf.indent = nullptr;
+	conf.trailingCommas = false;
+	conf.bareKeys = false;
+	std::ostringstream os;
+	Json5::serialize(os, v, conf);
+	return os.str();
+}
+
+void finishesWithin(double seconds, const char *what, std::function<void()> fn) {
+	struct State {
+		std::mutex mut;
+		std::condition_variable cond;
+		bool done = false;
+	};
+
+	std::shared_ptr<State> state = std::make_shared<State>();
+	std::thread([state, fn] {
+		fn();
+		std::lock_guard<std::mutex> lock(state->mut);
+		state->done = true;
+		state->cond.notify_all();
+	}).detach();
+
+	std::unique_lock<std::mutex> lock(state->mut);
+	if (!state->cond.wait_for(
+			lock, std::chrono::duration<double>(seconds), [&] { return state->done; })) {
+		std::cout << "\n  " << what << " didn't finish within " << seconds << "s" << std::endl;
+		std::_Exit(1);
+	}
+}
+
+static std::vector<std::string> tempDirs;
+
+std::string tempDir() {
+	const char *tmp = getenv("TMPDIR");
+	std::string tmpl = std::string(tmp ? tmp : "/tmp") + "/json5cpp-test-XXXXXX";
+	std::vector<char> path(tmpl.begin(), tmpl.end());
+	path.push_back('\0');
+	if (!mkdtemp(path.data())) {
+		std::cout << "Couldn't create a temporary directory: " << strerror(errno) << '\n';
+		std::_Exit(1);
+	}
+
+	tempDirs.push_back(path.data());
+	return path.data();
+}
+
+void writeFile(const std::string &path, const std::string &content) {
+	std::ofstream os(path, std::ios::binary);
+	os << content;
+}
+
+int main(int argc, char **argv) {
+	int numTests = 0;
+	int numFailed = 0;
+	for (const TestCase &tc: testCases()) {
+		// Only run the tests whose name contains the argument, if there is one
+		if (argc > 1 && !strstr(tc.name, argv[1])) {
+			continue;
+		}
+
+		numTests += 1;
+		std::cout << tc.name << ": " << std::flush;
+		int failuresBefore = numFailures;
+		tc.fn();
+		if (numFailures == failuresBefore) {
+			std::cout << "OK\n";
+		} else {
+			std::cout << "\n" << tc.name << ": FAILED\n";
+			numFailed += 1;
+		}
+	}
+
+	for (const std::string &dir: tempDirs) {
+		if (system(("rm -rf '" + dir + "'").c_str()) != 0) {
+			std::cout << "Couldn't remove " << dir << '\n';
+		}
+	}
+
+	std::cout << (numTests - numFailed) << '/' << numTests << " tests succeeded.\n";
+	return numFailed == 0 ? 0 : 1;
+}
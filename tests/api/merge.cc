@@ -0,0 +1,95 @@
+#include "test.h"
+
+static Json5::ParseConfig mergeConfig() {
+	Json5::ParseConfig conf;
+	conf.merge = true;
+	return conf;
+}
+
+static void mergeOk(Json::Value &v, const std::string &doc, Json5::ParseConfig conf = mergeConfig()) {
+	std::string err;
+	if (!Json5::parse(doc.data(), doc.size(), v, &err, conf)) {
+		checkFailed(__FILE__, __LINE__, "Merging '" + doc + "' failed: " + err);
+	}
+}
+
+TEST(mergeObjects) {
+	Json::Value v = parseOk("{a: 1, b: {c: 2, d: [1, 2]}, e: 'x'}");
+	mergeOk(v, "{b: {c: 3, f: true}, g: null}");
+	CHECK_EQ(toJson(v), "{\"a\":1,\"b\":{\"c\":3,\"d\":[1,2],\"f\":true},\"e\":\"x\",\"g\":null}");
+}
+
+TEST(mergeReplacesEverythingElse) {
+	Json::Value v = parseOk("{a: [1, 2, 3], b: {c: 1}, d: 5}");
+	mergeOk(v, "{a: [4], b: 'str', d: {e: 1}}");
+	CHECK_EQ(toJson(v), "{\"a\":[4],\"b\":\"str\",\"d\":{\"e\":1}}");
+
+	// A non-object document replaces the whole value
+	mergeOk(v, "[1]");
+	CHECK_EQ(toJson(v), "[1]");
+
+	// And an object replaces a non-object value
+	mergeOk(v, "{x: 1}");
+	CHECK_EQ(toJson(v), "{\"x\":1}");
+}
+
+TEST(mergeLayers) {
+	Json::Value config;
+	mergeOk(config, "{server: {host: 'localhost', port: 80}, debug: false}");
+	mergeOk(config, "{server: {port: 8080}}");
+	mergeOk(config, "{debug: true, server: {tls: {cert: 'a.pem'}}}");
+	CHECK_EQ(toJson(config),
+		"{\"debug\":true,\"server\":{\"host\":\"localhost\",\"port\":8080,\"tls\":{\"cert\":\"a.pem\"}}}");
+}
+
+TEST(mergeDuplicateKeys) {
+	// Within a document, later duplicates merge too
+	Json::Value v;
+	mergeOk(v, "{a: {b: 1}, a: {c: 2}, d: 1, d: 2}");
+	CHECK_EQ(toJson(v), "{\"a\":{\"b\":1,\"c\":2},\"d\":2}");
+
+	// Without merge, the last one wins
+	CHECK_EQ(toJson(parseOk("{a: {b: 1}, a: {c: 2}}")), "{\"a\":{\"c\":2}}");
+}
+
+TEST(mergeWithoutMergeReplaces) {
+	Json::Value v = parseOk("{a: 1}");
+	Json5::ParseConfig conf;
+	std::string doc = "{b: 2}";
+	CHECK(Json5::parse(doc.data(), doc.size(), v, nullptr, conf));
+	CHECK_EQ(toJson(v), "{\"b\":2}");
+}
+
+TEST(mergeWithOtherOptions) {
+	Json::Value v = parseOk("{a: {b: 1}, c: 2}");
+	std::vector<std::string> paths = {"/a/d"};
+	Json5::ParseConfig conf = mergeConfig();
+	conf.paths = &paths;
+	mergeOk(v, "{a: {d: 4, e: 5}, c: 3}", conf);
+	CHECK_EQ(toJson(v), "{\"a\":{\"b\":1,\"d\":4},\"c\":2}");
+
+	conf = mergeConfig();
+	Json5::SourceMap map;
+	conf.sourceMap = &map;
+	mergeOk(v, "{a: {b: 10}}", conf);
+	CHECK_EQ(toJson(v), "{\"a\":{\"b\":10,\"d\":4},\"c\":2}");
+	const Json5::SourceMap::Span *span = map.find(v["a"]["b"]);
+	CHECK(span != nullptr);
+	CHECK(span && span->start == 8 && span->limit == 10);
+}
+
+TEST(mergeErrorLeavesPartial) {
+	Json::Value v = parseOk("{a: 1, b: 2}");
+	std::string doc = "{a: 10, c: }";
+	CHECK(!Json5::parse(doc.data(), doc.size(), v, nullptr, mergeConfig()));
+	CHECK_EQ(v["a"].asInt(), 10);
+	CHECK_EQ(v["b"].asInt(), 2);
+}
+
+TEST(mergeParser) {
+	Json5::Parser parser(mergeConfig());
+	Json::Value v;
+	CHECK(parser.parse("{a: 1}", 6, v));
+	CHECK(parser.parse("{b: 2}", 6, v));
+	CHECK_EQ(toJson(v), "{\"a\":1,\"b\":2}");
+}
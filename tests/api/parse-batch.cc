@@ -0,0 +1,75 @@
+#include "test.h"
+
+static std::vector<std::string> makeDocuments(size_t count) {
+	std::vector<std::string> docs;
+	for (size_t i = 0; i < count; ++i) {
+		if (i % 7 == 3) {
+			docs.push_back("{bad: " + std::to_string(i));
+		} else {
+			docs.push_back("{i: " + std::to_string(i) + ", s: 'doc'}");
+		}
+	}
+
+	return docs;
+}
+
+static void checkBatch(const std::vector<std::string> &docs, unsigned int threads) {
+	std::vector<Json5::Buffer> buffers;
+	for (const std::string &doc: docs) {
+		buffers.push_back(Json5::Buffer{doc.data(), doc.size()});
+	}
+
+	std::vector<Json5::ParseResult> results =
+		Json5::parseBatch(buffers.data(), buffers.size(), {}, threads);
+	CHECK_EQ(results.size(), docs.size());
+	for (size_t i = 0; i < results.size() && i < docs.size(); ++i) {
+		Json::Value v;
+		std::string err;
+		Json5::ParseError error;
+		Json5::ParseConfig conf;
+		conf.error = &error;
+		bool ok = Json5::parse(docs[i].data(), docs[i].size(), v, &err, conf);
+		CHECK_EQ(results[i].ok, ok);
+		if (ok) {
+			CHECK_EQ(toJson(results[i].value), toJson(v));
+		} else {
+			CHECK_EQ(results[i].err, err);
+			CHECK_EQ(results[i].error.code, error.code);
+			CHECK_EQ(results[i].error.offset, error.offset);
+		}
+	}
+}
+
+TEST(parseBatchSingleThread) {
+	checkBatch(makeDocuments(50), 1);
+}
+
+TEST(parseBatchThreads) {
+	checkBatch(makeDocuments(1000), 4);
+	checkBatch(makeDocuments(3), 8);
+}
+
+TEST(parseBatchAllCores) {
+	checkBatch(makeDocuments(100), 0);
+}
+
+TEST(parseBatchEmpty) {
+	CHECK(Json5::parseBatch(nullptr, 0, {}, 4).empty());
+}
+
+TEST(parseBatchConfig) {
+	std::string doc = "{a: 1, b: 2}";
+	Json5::Buffer buf{doc.data(), doc.size()};
+	std::vector<std::string> paths = {"/b"};
+	Json5::ParseConfig conf;
+	conf.paths = &paths;
+	std::vector<Json5::ParseResult> results = Json5::parseBatch(&buf, 1, conf);
+	CHECK(results[0].ok);
+	CHECK_EQ(toJson(results[0].value), "{\"b\":2}");
+
+	conf.paths = nullptr;
+	conf.strictJson = true;
+	results = Json5::parseBatch(&buf, 1, conf, 2);
+	CHECK(!results[0].ok);
+	CHECK_EQ(results[0].error.code, Json5::ERROR_EXPECTED_STRING_KEY);
+}
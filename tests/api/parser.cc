@@ -0,0 +1,100 @@
+#include "test.h"
+
+#include <thread>
+
+static Json::Value parseWith(Json5::Parser &parser, const std::string &doc) {
+	Json::Value v;
+	std::string err;
+	if (!parser.parse(doc.data(), doc.size(), v, &err)) {
+		checkFailed(__FILE__, __LINE__, "Parsing '" + doc + "' failed: " + err);
+	}
+
+	return v;
+}
+
+TEST(parserReuse) {
+	Json5::Parser parser;
+	CHECK_EQ(toJson(parseWith(parser, "{a: 'long string with \\n escapes', b: [1, 2.5]}")),
+		"{\"a\":\"long string with \\n escapes\",\"b\":[1,2.5]}");
+	CHECK_EQ(toJson(parseWith(parser, "'x'")), "\"x\"");
+	CHECK_EQ(toJson(parseWith(parser, "[0x10, 1e2]")), "[16,100.0]");
+
+	// The streaming API shares the same state
+	std::istringstream is("{c: null}");
+	Json::Value v;
+	CHECK(parser.parse(is, v));
+	CHECK_EQ(toJson(v), "{\"c\":null}");
+}
+
+TEST(parserErrorsDontLeak) {
+	Json5::Parser parser;
+	Json::Value v;
+	std::string err;
+	CHECK(!parser.parse("{a: 'unterminated", 17, v, &err));
+	CHECK_EQ(err, "1:19: Unexpected EOF");
+
+	err.clear();
+	CHECK(parser.parse("'fine'", 6, v, &err));
+	CHECK_EQ(err, "");
+	CHECK_EQ(v.asString(), "fine");
+
+	CHECK(!parser.validate("[1 2]", 5, &err));
+	CHECK_EQ(err, "1:4: Expected ',' or ']'");
+	CHECK(parser.validate("[1, 2]", 6));
+}
+
+TEST(parserConfig) {
+	Json5::ParseConfig conf;
+	std::vector<std::string> paths = {"/a"};
+	conf.paths = &paths;
+	conf.strictJson = true;
+	Json5::Parser parser(conf);
+
+	// The paths are compiled when the parser is constructed
+	paths.clear();
+	CHECK_EQ(toJson(parseWith(parser, "{\"a\": 1, \"b\": 2}")), "{\"a\":1}");
+
+	Json::Value v;
+	CHECK(!parser.parse("{a: 1}", 6, v));
+}
+
+TEST(parserMove) {
+	Json5::ParseConfig conf;
+	conf.maxDepth = 2;
+	Json5::Parser a(conf);
+	Json5::Parser b(std::move(a));
+	Json::Value v;
+	CHECK(!b.parse("[[[]]]", 6, v));
+
+	Json5::Parser c;
+	c = std::move(b);
+	CHECK(!c.parse("[[[]]]", 6, v));
+	CHECK(c.parse("[[]]", 4, v));
+}
+
+TEST(parserPerThread) {
+	std::vector<std::thread> threads;
+	std::vector<int> failures(4);
+	for (size_t i = 0; i < failures.size(); ++i) {
+		threads.emplace_back([&failures, i] {
+			Json5::Parser parser;
+			for (int n = 0; n < 200; ++n) {
+				std::string doc = "{n: " + std::to_string(n) + ", s: 'x" + std::to_string(i) + "'}";
+				Json::Value v;
+				if (
+						!parser.parse(doc.data(), doc.size(), v) ||
+						v["n"].asInt() != n || v["s"].asString() != "x" + std::to_string(i)) {
+					failures[i] += 1;
+				}
+			}
+		});
+	}
+
+	for (std::thread &t: threads) {
+		t.join();
+	}
+
+	for (int f: failures) {
+		CHECK_EQ(f, 0);
+	}
+}
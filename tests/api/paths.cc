@@ -0,0 +1,107 @@
+#include "test.h"
+
+static Json::Value parsePaths(const std::string &doc, std::vector<std::string> paths) {
+	Json5::ParseConfig conf;
+	conf.paths = &paths;
+	return parseOk(doc, conf);
+}
+
+static std::string parsePathsErr(const std::string &doc, std::vector<std::string> paths) {
+	Json5::ParseConfig conf;
+	conf.paths = &paths;
+	std::string err;
+	finishesWithin(5, doc.c_str(), [&] { err = parseErr(doc, conf); });
+	return err;
+}
+
+TEST(pathsSelectSubtrees) {
+	const char *doc = "{a: {b: 1, c: [2, 3]}, d: 'x', e: {f: null}}";
+	CHECK_EQ(toJson(parsePaths(doc, {"/a/c"})), "{\"a\":{\"c\":[2,3]}}");
+	CHECK_EQ(toJson(parsePaths(doc, {"/a/b", "/e"})), "{\"a\":{\"b\":1},\"e\":{\"f\":null}}");
+	CHECK_EQ(toJson(parsePaths(doc, {"/a/c/1"})), "{\"a\":{\"c\":[null,3]}}");
+	CHECK_EQ(toJson(parsePaths(doc, {"/a", "/a/b"})), "{\"a\":{\"b\":1,\"c\":[2,3]}}");
+	CHECK_EQ(toJson(parsePaths(doc, {""})), toJson(parseOk(doc)));
+}
+
+TEST(pathsMissing) {
+	// Nothing matches, so only the root is left
+	CHECK_EQ(toJson(parsePaths("{a: 1}", {"/b"})), "{}");
+	CHECK_EQ(toJson(parsePaths("[1, 2]", {"/5"})), "[]");
+	CHECK_EQ(toJson(parsePaths("{a: 1}", {"/a/b"})), "{}");
+}
+
+TEST(pathsEscapes) {
+	const char *doc = "{'a/b': 1, 'c~d': 2, '': 3}";
+	CHECK_EQ(toJson(parsePaths(doc, {"/a~1b"})), "{\"a/b\":1}");
+	CHECK_EQ(toJson(parsePaths(doc, {"/c~0d"})), "{\"c~d\":2}");
+	CHECK_EQ(toJson(parsePaths(doc, {"/"})), "{\"\":3}");
+}
+
+TEST(pathsInvalid) {
+	Json5::ParseConfig conf;
+	std::vector<std::string> paths = {"a"};
+	conf.paths = &paths;
+	Json5::ParseError error;
+	conf.error = &error;
+	parseErr("{a: 1}", conf);
+	CHECK_EQ(error.code, Json5::ERROR_INVALID_PATHS);
+}
+
+TEST(pathsSkippedSyntax) {
+	// The skipped parts may contain anything JSON5 allows
+	const char *doc =
+		"{a: [1, 'x]y', \"}\", {b: [[]]}, /* ] */ Infinity, 0x1F, +.5e3,], // }\n"
+		"b: 2}";
+	CHECK_EQ(toJson(parsePaths(doc, {"/b"})), "{\"b\":2}");
+}
+
+TEST(pathsMalformedSkippedSubtree) {
+	// Skipped values are validated like everything else, with the same errors
+	CHECK_EQ(parsePathsErr("{\"a\": [/], \"b\": 1}", {"/b"}), "1:8: Invalid start character in identifier");
+	CHECK_EQ(parsePathsErr("{\"a\": [1 / 2], \"b\": 1}", {"/b"}), "1:10: Expected ',' or ']'");
+	CHECK_EQ(parsePathsErr("{\"a\": /, \"b\": 1}", {"/b"}), "1:7: Invalid start character in identifier");
+	CHECK_EQ(parsePathsErr("{\"skip\": [1, 2}, \"keep\": 1}", {"/keep"}), "1:15: Expected ',' or ']'");
+	CHECK_EQ(parsePathsErr("{\"a\": [}, \"b\": 1}", {"/b"}), "1:8: Invalid start character in identifier");
+	CHECK_EQ(parsePathsErr("{\"a\": {], \"b\": 1}", {"/b"}), "1:8: Invalid start character in identifier");
+	CHECK_EQ(parsePathsErr("[[1, {}}, 2]", {"/1"}), "1:8: Expected ',' or ']'");
+
+	CHECK(parsePathsErr("{\"a\": [1, \"b\": 1}", {"/b"}) != "");
+	CHECK(parsePathsErr("{\"a\": ['x], \"b\": 1}", {"/b"}) != "");
+	CHECK(parsePathsErr("{\"a\": [[[", {"/b"}) != "");
+}
+
+TEST(pathsDontChangeValidity) {
+	// Whatever is selected, a document is accepted or rejected like without paths
+	const char *docs[] = {
+		"{a: [1, 2}, b: 1}", "{a: {c: 1], b: 1}", "{a: [1 2], b: 1}", "{a: {c 1}, b: 1}",
+		"{a: [tru], b: 1}", "{a: {c: 1,,}, b: 1}", "{a: '\\u12', b: 1}", "{a: 1e, b: 1}",
+		"{a: [[]], b: 1}", "{a: {'c': [1, {d: null}]}, b: 1}", "[1, [2, {]], 3]"};
+	for (const char *doc: docs) {
+		for (const char *path: {"/b", "/a", "/a/c", "/0", "/nothing"}) {
+			std::vector<std::string> paths = {path};
+			Json5::ParseConfig conf;
+			conf.paths = &paths;
+			Json::Value v;
+			std::string err, fullErr;
+			bool ok = Json5::parse(doc, strlen(doc), v, &err, conf);
+			bool fullOk = Json5::parse(doc, strlen(doc), v, &fullErr);
+			if (ok != fullOk || err != fullErr) {
+				checkFailed(__FILE__, __LINE__,
+					std::string("'") + doc + "' with '" + path + "' gave '" + err +
+					"' instead of '" + fullErr + "'");
+			}
+		}
+	}
+}
+
+TEST(pathsDepthLimit) {
+	Json5::ParseConfig conf;
+	std::vector<std::string> paths = {"/b"};
+	conf.paths = &paths;
+	conf.maxDepth = 10;
+	std::string doc = "{a: " + std::string(20, '[') + std::string(20, ']') + ", b: 1}";
+	Json5::ParseError error;
+	conf.error = &error;
+	parseErr(doc, conf);
+	CHECK_EQ(error.code, Json5::ERROR_DEPTH_LIMIT);
+}
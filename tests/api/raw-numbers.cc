@@ -0,0 +1,88 @@
+#include "test.h"
+
+static Json5::ParseConfig rawConfig() {
+	Json5::ParseConfig conf;
+	conf.rawNumbers = true;
+	return conf;
+}
+
+TEST(rawNumbersKeepText) {
+	Json::Value v = parseOk("[0x1F, 12345678901234567890, 1.10, -0, +5, .5, Infinity, -NaN]", rawConfig());
+	const char *texts[] = {
+		"0x1F", "12345678901234567890", "1.10", "-0", "+5", ".5", "Infinity", "-NaN"};
+	CHECK_EQ(v.size(), 8u);
+	for (Json::ArrayIndex i = 0; i < v.size(); ++i) {
+		CHECK(Json5::isRawNumber(v[i]));
+		CHECK_EQ(v[i].asString(), texts[i]);
+	}
+}
+
+TEST(rawNumbersAreNotStrings) {
+	Json::Value v = parseOk("{a: '12', b: 12, c: true, d: null}", rawConfig());
+	CHECK(!Json5::isRawNumber(v["a"]));
+	CHECK(Json5::isRawNumber(v["b"]));
+	CHECK(!Json5::isRawNumber(v["c"]));
+	CHECK(!Json5::isRawNumber(v["d"]));
+
+	// Copies stay raw numbers, but a string built from the text doesn't
+	Json::Value copy = v["b"];
+	CHECK(Json5::isRawNumber(copy));
+	CHECK(!Json5::isRawNumber(Json::Value(v["b"].asString())));
+
+	// Without rawNumbers, numbers are converted as usual
+	CHECK(!Json5::isRawNumber(parseOk("12")));
+}
+
+TEST(rawNumbersConvert) {
+	const char *numbers[] = {
+		"0", "-0", "1", "-1", "2147483647", "-2147483648", "4294967295", "4294967296",
+		"9223372036854775807", "-9223372036854775808", "18446744073709551615",
+		"18446744073709551616", "1.5", "-1e300", ".5", "5.", "+7", "0xff",
+		"-0xFF", "0xffffffffffffffff", "Infinity", "-Infinity", "NaN", "1E-7"};
+	for (const char *num: numbers) {
+		Json::Value raw = parseOk(num, rawConfig());
+		Json::Value converted = Json5::convertNumber(raw);
+		Json::Value expected = parseOk(num);
+		CHECK_EQ(converted.type(), expected.type());
+		if (expected.isDouble() && expected.asDouble() != expected.asDouble()) {
+			CHECK(converted.asDouble() != converted.asDouble());
+		} else if (!(converted == expected)) {
+			checkFailed(__FILE__, __LINE__,
+				std::string("Converting ") + num + " gave " + toJson(converted));
+		}
+	}
+
+	// Anything else is returned as is
+	CHECK_EQ(Json5::convertNumber(Json::Value("12")), Json::Value("12"));
+	CHECK_EQ(Json5::convertNumber(Json::Value(3)), Json::Value(3));
+}
+
+TEST(rawNumbersRoundTrip) {
+	const char *doc = "{big: 123456789012345678901234567890, exact: 0.1000000000000000000001, hex: 0x1F}";
+	Json::Value v = parseOk(doc, rawConfig());
+	Json5::SerializeConfig conf;
+	conf.indent = nullptr;
+	std::ostringstream os;
+	Json5::serialize(os, v, conf);
+	CHECK_EQ(os.str(), "{big:123456789012345678901234567890,exact:0.1000000000000000000001,hex:0x1F,}");
+
+	Json::Value again = parseOk(os.str(), rawConfig());
+	CHECK(Json5::isRawNumber(again["big"]));
+	CHECK_EQ(again["big"].asString(), "123456789012345678901234567890");
+}
+
+TEST(rawNumbersStillValidated) {
+	Json5::ParseConfig conf = rawConfig();
+	for (const char *doc: {"1e", "0x", "--1", "1.2.3", "Infinit"}) {
+		Json::Value v;
+		if (Json5::parse(doc, strlen(doc), v, nullptr, conf)) {
+			checkFailed(__FILE__, __LINE__, "Accepted '" + std::string(doc) + "'");
+		}
+	}
+
+	conf.strictJson = true;
+	Json::Value v;
+	CHECK(!Json5::parse("0x10", 4, v, nullptr, conf));
+	CHECK(Json5::parse("-1.5e3", 6, v, nullptr, conf));
+	CHECK_EQ(v.asString(), "-1.5e3");
+}
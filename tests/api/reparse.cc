@@ -0,0 +1,141 @@
+#include "test.h"
+
+// Whether two values are equal, offsets included
+static bool sameWithOffsets(const Json::Value &a, const Json::Value &b) {
+	if (
+			a.getOffsetStart() != b.getOffsetStart() ||
+			a.getOffsetLimit() != b.getOffsetLimit() ||
+			a.type() != b.type() || a.size() != b.size()) {
+		return false;
+	}
+
+	if (a.isObject()) {
+		for (const std::string &key: a.getMemberNames()) {
+			if (!b.isMember(key) || !sameWithOffsets(a[key], b[key])) {
+				return false;
+			}
+		}
+
+		return true;
+	} else if (a.isArray()) {
+		for (Json::ArrayIndex i = 0; i < a.size(); ++i) {
+			if (!sameWithOffsets(a[i], b[i])) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	return a == b;
+}
+
+// Apply an edit with reparse, and check that the result is the same as a full parse
+static void checkEdit(
+		const std::string &doc, size_t offset, size_t removed, const std::string &inserted) {
+	Json5::ParseConfig conf;
+	conf.recordOffsets = true;
+
+	std::string text = doc;
+	Json::Value v;
+	if (!Json5::parse(text.data(), text.size(), v, nullptr, conf)) {
+		checkFailed(__FILE__, __LINE__, "Couldn't parse '" + doc + "'");
+		return;
+	}
+
+	std::string err;
+	bool ok = Json5::reparse(text, v, offset, removed, inserted, &err, conf);
+
+	std::string expectedText = doc;
+	expectedText.replace(offset, removed, inserted);
+	CHECK_EQ(text, expectedText);
+
+	Json::Value expected;
+	std::string expectedErr;
+	bool expectedOk = Json5::parse(
+		expectedText.data(), expectedText.size(), expected, &expectedErr, conf);
+	CHECK_EQ(ok, expectedOk);
+	CHECK_EQ(err, expectedErr);
+	if (!ok) {
+		CHECK(v.isNull());
+	} else if (!sameWithOffsets(v, expected)) {
+		checkFailed(__FILE__, __LINE__, "Reparsing '" + expectedText + "' gave " + toJson(v));
+	}
+}
+
+TEST(reparseScalars) {
+	const std::string doc = "{a: 1, b: [true, 'str', 3.5], c: {d: null}}";
+	checkEdit(doc, 4, 1, "12345");
+	checkEdit(doc, 4, 1, "'x'");
+	checkEdit(doc, 17, 5, "'longer string'");
+	checkEdit(doc, 11, 4, "false");
+	checkEdit(doc, 38, 4, "[1, 2]");
+}
+
+TEST(reparseStructure) {
+	const std::string doc = "{a: 1, b: [true, 'str', 3.5], c: {d: null}}";
+	// Inserting elements and members
+	checkEdit(doc, 15, 0, ", 7");
+	checkEdit(doc, 42, 0, ", e: 5");
+	// Removing them
+	checkEdit(doc, 15, 7, "");
+	checkEdit(doc, 5, 23, "");
+	// Changing a key
+	checkEdit(doc, 7, 1, "bb");
+	checkEdit(doc, 0, doc.size(), "[1]");
+}
+
+TEST(reparseComments) {
+	const std::string doc = "[1, /* a */ 2, // b\n 3]";
+	checkEdit(doc, 6, 1, "xyz");
+	checkEdit(doc, 4, 0, "0, ");
+	checkEdit(doc, 17, 1, "c\n4,");
+	checkEdit(doc, 5, 0, "*/ 9 /*");
+}
+
+TEST(reparseErrors) {
+	const std::string doc = "{a: [1, 2], b: 'x'}";
+	checkEdit(doc, 5, 1, "");
+	checkEdit(doc, 5, 0, "[");
+	checkEdit(doc, 15, 1, "");
+	checkEdit(doc, 0, 1, "");
+}
+
+TEST(reparseEveryPosition) {
+	// Insert and remove a character at every offset
+	const std::string doc = "{a: [1, 'two', {three: 3}], 'b': -0x4, c: [[], {}]}";
+	for (size_t i = 0; i <= doc.size(); ++i) {
+		checkEdit(doc, i, 0, "5");
+		checkEdit(doc, i, 0, " ");
+		checkEdit(doc, i, 0, ",");
+		if (i < doc.size()) {
+			checkEdit(doc, i, 1, "");
+			checkEdit(doc, i, 1, "9");
+		}
+	}
+}
+
+TEST(reparseInvalidEdit) {
+	Json5::ParseConfig conf;
+	conf.recordOffsets = true;
+	std::string text = "[1]";
+	Json::Value v;
+	CHECK(Json5::parse(text.data(), text.size(), v, nullptr, conf));
+
+	Json5::ParseError error;
+	conf.error = &error;
+	std::string err;
+	CHECK(!Json5::reparse(text, v, 2, 5, "x", &err, conf));
+	CHECK_EQ(error.code, Json5::ERROR_INVALID_EDIT);
+	CHECK_EQ(text, "[1]");
+}
+
+TEST(reparseWithoutOffsets) {
+	// Without offsets, the whole document is parsed again
+	std::string text = "{a: 1}";
+	Json::Value v = parseOk(text);
+	Json5::ParseConfig conf;
+	conf.recordOffsets = true;
+	CHECK(Json5::reparse(text, v, 4, 1, "2", nullptr, conf));
+	CHECK_EQ(toJson(v), "{\"a\":2}");
+}
@@ -0,0 +1,117 @@
+#include "test.h"
+
+static std::string serialized(const Json::Value &v, Json5::SerializeConfig conf) {
+	std::ostringstream os;
+	Json5::serialize(os, v, conf);
+	return os.str();
+}
+
+static Json::Value bigDocument() {
+	Json::Value v;
+	for (int i = 0; i < 500; ++i) {
+		Json::Value &item = v["items"][i];
+		item["id"] = i;
+		item["name"] = "item " + std::to_string(i);
+		item["tags"][0] = i % 3 == 0;
+		item["tags"][1] = i * 0.25;
+	}
+
+	for (int i = 0; i < 300; ++i) {
+		v["map"]["key" + std::to_string(i)] = Json::Value(Json::arrayValue);
+	}
+
+	v["small"][0] = 1;
+	return v;
+}
+
+TEST(serializeParallelMatchesSequential) {
+	Json::Value v = bigDocument();
+	Json5::SerializeConfig conf;
+	std::string expected = serialized(v, conf);
+
+	conf.parallelThreshold = 10;
+	for (unsigned int threads: {1u, 2u, 3u, 8u, 0u}) {
+		conf.threads = threads;
+		CHECK_EQ(serialized(v, conf), expected);
+	}
+}
+
+TEST(serializeParallelConfigs) {
+	Json::Value v = bigDocument();
+	Json5::SerializeConfig conf;
+	conf.indent = nullptr;
+	conf.trailingCommas = false;
+	conf.bareKeys = false;
+	std::string expected = serialized(v, conf);
+	CHECK_EQ(expected, toJson(v));
+
+	conf.threads = 4;
+	conf.parallelThreshold = 1;
+	CHECK_EQ(serialized(v, conf), expected);
+
+	conf.indent = "    ";
+	conf.trailingCommas = true;
+	conf.threads = 1;
+	expected = serialized(v, conf);
+	conf.threads = 4;
+	CHECK_EQ(serialized(v, conf), expected);
+}
+
+TEST(serializeParallelSmall) {
+	// Fewer children than threads, and empty containers
+	Json5::SerializeConfig conf;
+	conf.threads = 16;
+	conf.parallelThreshold = 0;
+	CHECK_EQ(serialized(Json::Value(Json::arrayValue), conf), "[]");
+	CHECK_EQ(serialized(Json::Value(Json::objectValue), conf), "{}");
+
+	Json::Value v;
+	v[0] = 1;
+	v[1] = "two";
+	conf.threads = 1;
+	std::string expected = serialized(v, conf);
+	conf.threads = 16;
+	CHECK_EQ(serialized(v, conf), expected);
+}
+
+TEST(serializeParallelNested) {
+	// Big containers inside big containers, and several big siblings,
+	// all share the same threads
+	Json::Value v;
+	for (int i = 0; i < 20; ++i) {
+		Json::Value &inner = v["outer"][i];
+		for (int j = 0; j < 50; ++j) {
+			inner[j]["n"] = i * 50 + j;
+			inner[j]["deeper"][0] = "x" + std::to_string(j);
+		}
+	}
+
+	for (int i = 0; i < 5; ++i) {
+		Json::Value &sibling = v["sibling" + std::to_string(i)];
+		for (int j = 0; j < 100; ++j) {
+			sibling[j] = j;
+		}
+	}
+
+	Json5::SerializeConfig conf;
+	std::string expected = serialized(v, conf);
+
+	for (unsigned int threshold: {0u, 10u, 50u, 100u}) {
+		conf.parallelThreshold = threshold;
+		for (unsigned int threads: {2u, 3u, 8u, 0u}) {
+			conf.threads = threads;
+			CHECK_EQ(serialized(v, conf), expected);
+		}
+	}
+
+	// Typed serialization of Json::Values splits them up the same way
+	std::vector<Json::Value> values = {v, v["outer"], Json::Value(1)};
+	conf.threads = 4;
+	conf.parallelThreshold = 10;
+	std::ostringstream os;
+	Json5::serialize(os, values, conf);
+	conf.threads = 1;
+	std::ostringstream sequential;
+	Json5::serialize(sequential, values, conf);
+	CHECK_EQ(os.str(), sequential.str());
+}
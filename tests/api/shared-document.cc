@@ -0,0 +1,84 @@
+#include "test.h"
+
+#include <atomic>
+#include <thread>
+
+TEST(sharedDocumentReload) {
+	Json5::SharedDocument doc;
+	CHECK(doc.get() != nullptr);
+	CHECK(doc.get()->isNull());
+
+	std::string err;
+	CHECK(doc.reload("{a: 1}", 6, &err));
+	std::shared_ptr<const Json::Value> first = doc.get();
+	CHECK_EQ(toJson(*first), "{\"a\":1}");
+
+	std::istringstream is("{a: 2}");
+	CHECK(doc.reload(is, &err));
+	CHECK_EQ(toJson(*doc.get()), "{\"a\":2}");
+
+	// Documents stay valid after they're replaced
+	CHECK_EQ(toJson(*first), "{\"a\":1}");
+}
+
+TEST(sharedDocumentErrorsKeepCurrent) {
+	Json5::ParseConfig conf;
+	conf.strictJson = true;
+	Json5::SharedDocument doc(conf);
+	CHECK(doc.reload("{\"a\": 1}", 8));
+
+	std::string err;
+	CHECK(!doc.reload("{a: 2}", 6, &err));
+	CHECK_EQ(err, "1:2: Expected string key");
+	CHECK_EQ(toJson(*doc.get()), "{\"a\":1}");
+
+	CHECK(!doc.reloadFile("/nonexistent/file.json", &err));
+	CHECK(err.find("Couldn't open") != std::string::npos);
+	CHECK_EQ(toJson(*doc.get()), "{\"a\":1}");
+}
+
+TEST(sharedDocumentFileAndSet) {
+	std::string dir = tempDir();
+	writeFile(dir + "/config.json5", "{port: 8080}");
+
+	Json5::SharedDocument doc;
+	CHECK(doc.reloadFile(dir + "/config.json5"));
+	CHECK_EQ((*doc.get())["port"].asInt(), 8080);
+
+	std::shared_ptr<Json::Value> value = std::make_shared<Json::Value>("set");
+	doc.set(value);
+	CHECK(doc.get() == value);
+}
+
+TEST(sharedDocumentConcurrent) {
+	// Readers always see a whole document while a writer keeps replacing it
+	Json5::SharedDocument doc;
+	CHECK(doc.reload("{n: 0, copy: 0}", 15));
+
+	std::atomic<bool> done(false);
+	std::atomic<int> torn(0);
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 3; ++i) {
+		readers.emplace_back([&] {
+			while (!done) {
+				std::shared_ptr<const Json::Value> v = doc.get();
+				if ((*v)["n"].asInt() != (*v)["copy"].asInt()) {
+					torn += 1;
+				}
+			}
+		});
+	}
+
+	for (int n = 1; n <= 2000; ++n) {
+		std::string text = "{n: " + std::to_string(n) + ", copy: " + std::to_string(n) + "}";
+		doc.reload(text.data(), text.size());
+	}
+
+	done = true;
+	for (std::thread &t: readers) {
+		t.join();
+	}
+
+	CHECK_EQ(torn.load(), 0);
+	CHECK((*doc.get())["n"].asInt() == 2000);
+}
@@ -0,0 +1,237 @@
+#include "test.h"
+
+#include <limits>
+#include <math.h>
+
+static std::string snapshotOf(const Json::Value &v) {
+	std::ostringstream os;
+	std::string err;
+	if (!Json5::writeSnapshot(os, v, &err)) {
+		checkFailed(__FILE__, __LINE__, "writeSnapshot failed: " + err);
+	}
+
+	return os.str();
+}
+
+static const char *document =
+	"{name: 'snapshot', list: [1, -2, 3.5, true, false, null, 'str'], "
+	"nested: {a: {b: [[]]}, 'key with spaces': {}, '': 0}, "
+	"big: 18446744073709551615, small: -9223372036854775808, "
+	"dup: ['str', 'str', 'name']}";
+
+TEST(snapshotRoundTrip) {
+	Json::Value v = parseOk(document);
+	std::string data = snapshotOf(v);
+	Json5::Snapshot snap(data.data(), data.size());
+	CHECK(snap.valid());
+	CHECK_EQ(toJson(snap.root().toValue()), toJson(v));
+}
+
+TEST(snapshotQueries) {
+	std::string data = snapshotOf(parseOk(document));
+	Json5::Snapshot snap(data.data(), data.size());
+	Json5::SnapshotValue root = snap.root();
+
+	CHECK_EQ(root.type(), Json::objectValue);
+	CHECK_EQ(root.size(), 6u);
+	CHECK_EQ(std::string(root["name"].asCString()), "snapshot");
+	CHECK_EQ(root["list"].size(), 7u);
+	CHECK_EQ(root["list"][0].asInt64(), 1);
+	CHECK_EQ(root["list"][1].asInt64(), -2);
+	CHECK_EQ(root["list"][2].asDouble(), 3.5);
+	CHECK(root["list"][3].asBool());
+	CHECK(!root["list"][4].asBool());
+	CHECK(root["list"][5].isNull());
+	CHECK_EQ(root["list"][6].type(), Json::stringValue);
+	CHECK(root["list"][7].isNull());
+	CHECK_EQ(root["big"].asUInt64(), std::numeric_limits<Json::UInt64>::max());
+	CHECK_EQ(root["small"].asInt64(), std::numeric_limits<Json::Int64>::min());
+	CHECK_EQ(root["nested"]["a"]["b"][0].type(), Json::arrayValue);
+	CHECK(root.isMember("nested"));
+	CHECK(root["nested"].isMember(""));
+	CHECK(root["nested"].isMember("key with spaces"));
+	CHECK(!root.isMember("missing"));
+	CHECK(root["missing"]["deeper"].isNull());
+
+	// Keys are in sorted order
+	CHECK_EQ(std::string(root.key(0)), "big");
+	CHECK_EQ(std::string(root.key(5)), "small");
+	CHECK_EQ(std::string(root.key(6)), "");
+
+	// Strings, including keys, are only stored once
+	const char *a = root["dup"][0].asCString();
+	const char *b = root["dup"][1].asCString();
+	const char *c = root["dup"][2].asCString();
+	CHECK(a == b);
+	CHECK_EQ(std::string(root.key(3)), "name");
+	CHECK(c == root.key(3));
+
+	const char *begin, *end;
+	CHECK(root["name"].getString(&begin, &end));
+	CHECK_EQ(std::string(begin, end), "snapshot");
+	CHECK(!root["list"].getString(&begin, &end));
+}
+
+TEST(snapshotNumberConversions) {
+	Json::Value v(Json::arrayValue);
+	v.append(1e300);
+	v.append(-1e300);
+	v.append(std::numeric_limits<double>::quiet_NaN());
+	v.append(-0.5);
+	v.append(-1.5);
+	v.append(9223372036854775808.0);
+	v.append(18446744073709551616.0);
+	v.append(Json::UInt64(18446744073709551615ull));
+	v.append(Json::Int64(-5));
+	v.append(2.9);
+
+	std::string data = snapshotOf(v);
+	Json5::Snapshot snap(data.data(), data.size());
+	Json5::SnapshotValue root = snap.root();
+	const Json::Int64 int64Max = std::numeric_limits<Json::Int64>::max();
+	const Json::Int64 int64Min = std::numeric_limits<Json::Int64>::min();
+	const Json::UInt64 uint64Max = std::numeric_limits<Json::UInt64>::max();
+
+	CHECK_EQ(root[0].asInt64(), int64Max);
+	CHECK_EQ(root[0].asUInt64(), uint64Max);
+	CHECK_EQ(root[1].asInt64(), int64Min);
+	CHECK_EQ(root[1].asUInt64(), 0u);
+	CHECK_EQ(root[2].asInt64(), 0);
+	CHECK_EQ(root[2].asUInt64(), 0u);
+	CHECK(isnan(root[2].asDouble()));
+	CHECK_EQ(root[3].asInt64(), 0);
+	CHECK_EQ(root[3].asUInt64(), 0u);
+	CHECK_EQ(root[4].asInt64(), -1);
+	CHECK_EQ(root[4].asUInt64(), 0u);
+	CHECK_EQ(root[5].asInt64(), int64Max);
+	CHECK_EQ(root[5].asUInt64(), 9223372036854775808ull);
+	CHECK_EQ(root[6].asUInt64(), uint64Max);
+	CHECK_EQ(root[7].asInt64(), int64Max);
+	CHECK_EQ(root[8].asUInt64(), 0u);
+	CHECK_EQ(root[8].asInt64(), -5);
+	CHECK_EQ(root[9].asInt64(), 2);
+}
+
+TEST(snapshotRawNumbers) {
+	Json5::ParseConfig conf;
+	conf.rawNumbers = true;
+	std::string data = snapshotOf(parseOk("[0x10, 1.5, 12345678901234567890]", conf));
+	Json5::Snapshot snap(data.data(), data.size());
+	CHECK_EQ(toJson(snap.root().toValue()), "[16,1.5,12345678901234567890]");
+}
+
+TEST(snapshotTooDeep) {
+	Json::Value v;
+	Json::Value *leaf = &v;
+	for (int i = 0; i < 1001; ++i) {
+		leaf = &(*leaf)[0];
+	}
+	*leaf = 1;
+
+	std::ostringstream os;
+	std::string err;
+	CHECK(!Json5::writeSnapshot(os, v, &err));
+	CHECK_EQ(err, "Snapshot is too deep");
+
+	// One level less is fine
+	v = v[0];
+	std::string data = snapshotOf(v);
+	Json5::Snapshot snap(data.data(), data.size());
+	CHECK_EQ(toJson(snap.root().toValue()), toJson(v));
+}
+
+// A corrupt snapshot with a chain of 'levels' nested arrays
+static std::string deepSnapshot(uint32_t levels) {
+	std::string data(16, '\0');
+	data += '\0'; // null, at offset 16
+	uint32_t child = 16;
+	for (uint32_t i = 0; i < levels; ++i) {
+		uint32_t at = (uint32_t)data.size();
+		data += '\7'; // array
+		uint32_t fields[2] = {1, child};
+		data.append((const char *)fields, sizeof(fields));
+		child = at;
+	}
+
+	uint32_t header[4] = {0, 1, child, (uint32_t)data.size()};
+	memcpy(header, "J5SN", 4);
+	memcpy(&data[0], header, sizeof(header));
+	return data;
+}
+
+static int depthOf(const Json::Value &v) {
+	int depth = 0;
+	const Json::Value *it = &v;
+	while (it->isArray() && it->size() > 0) {
+		it = &(*it)[0];
+		depth += 1;
+	}
+
+	return depth;
+}
+
+TEST(snapshotCorruptDeep) {
+	// Deep enough to overflow the stack if toValue recursed without a bound
+	std::string data = deepSnapshot(1000000);
+	Json5::Snapshot snap(data.data(), data.size());
+	CHECK(snap.valid());
+	CHECK_EQ(snap.root().size(), 1u);
+
+	Json::Value v = snap.root().toValue();
+	CHECK_EQ(depthOf(v), 1000);
+
+	// Reading in place has no limit
+	Json5::SnapshotValue it = snap.root();
+	for (int i = 0; i < 5000; ++i) {
+		it = it[0];
+	}
+	CHECK_EQ(it.type(), Json::arrayValue);
+}
+
+TEST(snapshotCorrupt) {
+	std::string data = snapshotOf(parseOk(document));
+
+	// Every truncation is either rejected or reads as something
+	for (size_t size = 0; size < data.size(); ++size) {
+		Json5::Snapshot snap(data.data(), size);
+		if (snap.valid()) {
+			snap.root().toValue();
+		}
+	}
+
+	// Every flipped byte reads as something, without crashing
+	for (size_t i = 0; i < data.size(); ++i) {
+		std::string corrupt = data;
+		corrupt[i] ^= 0xff;
+		Json5::Snapshot snap(corrupt.data(), corrupt.size());
+		Json::Value v = snap.root().toValue();
+		(void)v;
+	}
+
+	std::string notSnapshot = "{\"a\": 1, \"padding\": true}";
+	CHECK(!Json5::Snapshot(notSnapshot.data(), notSnapshot.size()).valid());
+	CHECK(Json5::Snapshot().root().isNull());
+}
+
+TEST(snapshotFile) {
+	std::string dir = tempDir();
+	Json::Value v = parseOk(document);
+	writeFile(dir + "/doc.snap", snapshotOf(v));
+	writeFile(dir + "/bad.snap", "not a snapshot at all");
+
+	Json5::Snapshot snap;
+	std::string err;
+	CHECK(snap.openFile(dir + "/doc.snap", &err));
+	CHECK_EQ(toJson(snap.root().toValue()), toJson(v));
+
+	// A moved snapshot keeps the mapping
+	Json5::Snapshot moved(std::move(snap));
+	CHECK(!snap.valid());
+	CHECK_EQ(std::string(moved.root()["name"].asCString()), "snapshot");
+
+	CHECK(!moved.openFile(dir + "/bad.snap", &err));
+	CHECK(err.find("Invalid snapshot") != std::string::npos);
+	CHECK(!moved.valid());
+	CHECK(!moved.openFile(dir + "/missing.snap", &err));
+	CHECK(err.find("Couldn't open") != std::string::npos);
+}
@@ -0,0 +1,220 @@
+#include "test.h"
+
+#include <stdint.h>
+
+static const char *document =
+	"{\n"
+	"  a: [1, 'two'],\n"
+	"  // comment\n"
+	"  b: {c: null},\n"
+	"}\n";
+
+static Json::Value parseMapped(const std::string &doc, Json5::SourceMap &map, Json5::ParseConfig conf = {}) {
+	conf.sourceMap = &map;
+	return parseOk(doc, conf);
+}
+
+static std::string spansOf(const Json5::SourceMap &map) {
+	std::string out;
+	for (const Json5::SourceMap::Span &span: map.spans) {
+		out += (span.value ? "" : "~") + std::to_string(span.start) + "-" + std::to_string(span.limit);
+		out += span.parent == SIZE_MAX ? std::string(" ") : "<" + std::to_string(span.parent) + " ";
+	}
+
+	return out;
+}
+
+TEST(sourceMapSpans) {
+	Json5::SourceMap map;
+	Json::Value v = parseMapped(document, map);
+	CHECK_EQ(spansOf(map), "0-49 7-17<0 8-9<1 11-16<1 37-46<0 41-45<4 ");
+	CHECK(map.spans[0].value == &v);
+	CHECK(map.spans[1].value == &v["a"]);
+	CHECK(map.spans[3].value == &v["a"][1]);
+	CHECK(map.spans[5].value == &v["b"]["c"]);
+
+	CHECK_EQ(map.lines.size(), 6u);
+	const size_t lines[] = {0, 2, 19, 32, 48, 50};
+	for (size_t i = 0; i < map.lines.size(); ++i) {
+		CHECK_EQ(map.lines[i], lines[i]);
+	}
+}
+
+TEST(sourceMapFindOffset) {
+	Json5::SourceMap map;
+	Json::Value v = parseMapped(document, map);
+	CHECK(map.find(0) == &map.spans[0]);
+	CHECK(map.find(8) == &map.spans[2]);
+	CHECK(map.find(9) == &map.spans[1]); // The comma belongs to the array
+	CHECK(map.find(16) == &map.spans[1]);
+	CHECK(map.find(17) == &map.spans[0]);
+	CHECK(map.find(22) == &map.spans[0]); // Inside the comment
+	CHECK(map.find(44) == &map.spans[5]);
+	CHECK(map.find(48) == &map.spans[0]);
+	CHECK(map.find(49) == nullptr);
+	CHECK(map.find(1000) == nullptr);
+
+	// Leading whitespace isn't part of any value
+	parseMapped("  [1]", map);
+	CHECK(map.find(0) == nullptr);
+	CHECK(map.find(2) == &map.spans[0]);
+}
+
+TEST(sourceMapFindValue) {
+	Json5::SourceMap map;
+	Json::Value v = parseMapped(document, map);
+	CHECK(map.find(v) == &map.spans[0]);
+	CHECK(map.find(v["a"][0]) == &map.spans[2]);
+	CHECK(map.find(v["b"]) == &map.spans[4]);
+
+	// Copies and unrelated values aren't from the document
+	Json::Value copy = v["b"];
+	CHECK(map.find(copy) == nullptr);
+	CHECK(map.find(Json::Value(1)) == nullptr);
+
+	// Raw numbers are found too
+	Json5::ParseConfig conf;
+	conf.rawNumbers = true;
+	v = parseMapped("[1, 0x20]", map, conf);
+	CHECK(Json5::isRawNumber(v[1]));
+	CHECK(map.find(v[1]) == &map.spans[2]);
+	CHECK_EQ(map.spans[2].start, 4u);
+	CHECK_EQ(map.spans[2].limit, 8u);
+}
+
+TEST(sourceMapPosition) {
+	Json5::SourceMap map;
+	parseMapped(document, map);
+	int line = 0, column = 0;
+	map.position(0, line, column);
+	CHECK(line == 1 && column == 1);
+	map.position(1, line, column);
+	CHECK(line == 1 && column == 2);
+	map.position(34, line, column);
+	CHECK(line == 4 && column == 3);
+	map.position(48, line, column);
+	CHECK(line == 5 && column == 1);
+
+	// Positions agree with the ones in error messages
+	for (size_t offset = 0; offset < 49; ++offset) {
+		std::string doc = std::string(document).substr(0, offset) + "\x01";
+		Json5::ParseError error;
+		Json5::ParseConfig conf;
+		conf.error = &error;
+		Json::Value v;
+		CHECK(!Json5::parse(doc.data(), doc.size(), v, nullptr, conf));
+		if (error.offset == offset) {
+			map.position(offset, line, column);
+			CHECK_EQ(line, error.line);
+			CHECK_EQ(column, error.column);
+		}
+	}
+}
+
+TEST(sourceMapDuplicateKeys) {
+	Json5::SourceMap map;
+	Json::Value v = parseMapped("{a: [1, {b: 2}], a: 3}", map);
+	CHECK_EQ(spansOf(map), "0-22 ~4-15<0 ~5-6<1 ~8-14<1 ~12-13<3 20-21<0 ");
+	CHECK(map.find(v["a"]) == &map.spans[5]);
+
+	// Offsets inside a replaced value map to the nearest value which is still there
+	CHECK(map.find(5) == &map.spans[0]);
+	CHECK(map.find(12) == &map.spans[0]);
+	CHECK(map.find(20) == &map.spans[5]);
+}
+
+TEST(sourceMapReused) {
+	// Every parse clears the map, including failed ones
+	Json5::SourceMap map;
+	parseMapped(document, map);
+	Json5::ParseConfig conf;
+	conf.sourceMap = &map;
+	std::string err = parseErr("[1,\n2,\n", conf);
+	CHECK_EQ(err, "3:1: Unexpected EOF");
+	CHECK_EQ(map.lines.size(), 3u);
+
+	parseMapped("[\"x\"]", map);
+	CHECK_EQ(spansOf(map), "0-5 1-4<0 ");
+	CHECK_EQ(map.lines.size(), 1u);
+
+	// Streams give the same map
+	std::istringstream is(document);
+	Json::Value v;
+	CHECK(Json5::parse(is, v, nullptr, conf));
+	CHECK_EQ(spansOf(map), "0-49 7-17<0 8-9<1 11-16<1 37-46<0 41-45<4 ");
+	CHECK_EQ(map.lines.size(), 6u);
+}
+
+struct ErrorCase {
+	const char *doc;
+	Json5::ErrorCode code;
+	size_t offset;
+	int line;
+	int column;
+};
+
+TEST(parseErrorPositions) {
+	const ErrorCase cases[] = {
+		{"", Json5::ERROR_UNEXPECTED_EOF, 0, 1, 1},
+		{"{a: 1} x", Json5::ERROR_TRAILING_GARBAGE, 7, 1, 8},
+		{"[1 2]", Json5::ERROR_EXPECTED_COMMA_OR_BRACKET, 3, 1, 4},
+		{"[1,\n  2,\n  tru]", Json5::ERROR_INVALID_KEYWORD, 11, 3, 3},
+		{"'\\u12'", Json5::ERROR_INVALID_HEX, 3, 1, 4},
+		{"'a\nb'", Json5::ERROR_UNESCAPED_LINE_TERMINATOR, 3, 2, 1},
+		{"{\n1: 2}", Json5::ERROR_INVALID_IDENTIFIER_START, 2, 2, 1},
+		{"{a 1}", Json5::ERROR_EXPECTED_COLON, 3, 1, 4},
+		{"[1, 2,, 3]", Json5::ERROR_INVALID_IDENTIFIER_START, 6, 1, 7},
+		{"[\"\\uD800\"]", Json5::ERROR_EXPECTED_TRAILING_SURROGATE, 8, 1, 9},
+		{"1e", Json5::ERROR_INVALID_NUMBER, 0, 1, 1},
+		{"[1.2.3]", Json5::ERROR_EXPECTED_COMMA_OR_BRACKET, 4, 1, 5},
+		{"{\"a\": [1}, \"b\": 1}", Json5::ERROR_EXPECTED_COMMA_OR_BRACKET, 8, 1, 9},
+	};
+
+	for (const ErrorCase &c: cases) {
+		Json5::ParseError error;
+		Json5::ParseConfig conf;
+		conf.error = &error;
+		std::string err = parseErr(c.doc, conf);
+		if (error.code != c.code || error.offset != c.offset || error.line != c.line || error.column != c.column) {
+			checkFailed(__FILE__, __LINE__,
+				"'" + std::string(c.doc) + "' gave " + err + " at offset " + std::to_string(error.offset) +
+				" (code " + std::to_string(error.code) + ")");
+		}
+
+		// The message is the position and the code's message
+		CHECK_EQ(err,
+			std::to_string(c.line) + ":" + std::to_string(c.column) + ": " + Json5::errorMessage(c.code));
+	}
+}
+
+TEST(parseErrorWithoutMessage) {
+	Json5::ParseError error;
+	Json5::ParseConfig conf;
+	conf.error = &error;
+	conf.maxDepth = 2;
+	Json::Value v;
+	CHECK(!Json5::parse("[[[1]]]", 7, v, nullptr, conf));
+	CHECK_EQ(error.code, Json5::ERROR_DEPTH_LIMIT);
+	CHECK_EQ(error.offset, 2u);
+
+	// Successful parses leave it alone
+	CHECK(Json5::parse("[1]", 3, v, nullptr, conf));
+	CHECK_EQ(error.code, Json5::ERROR_DEPTH_LIMIT);
+	CHECK_EQ(error.offset, 2u);
+}
+
+TEST(parseErrorIo) {
+	Json5::ParseError error;
+	error.offset = 5;
+	Json5::ParseConfig conf;
+	conf.error = &error;
+	Json::Value v;
+	std::string err;
+	CHECK(!Json5::parseFile(tempDir() + "/missing.json5", v, &err, conf));
+	CHECK_EQ(error.code, Json5::ERROR_IO);
+	CHECK_EQ(error.offset, 0u);
+	CHECK_EQ(error.line, 0);
+	CHECK_EQ(error.column, 0);
+	CHECK(err.find("Couldn't open") != std::string::npos);
+	CHECK_EQ(std::string(Json5::errorMessage(Json5::ERROR_IO)), "Couldn't read file");
+}
@@ -0,0 +1,61 @@
+#include "test.h"
+
+static Json5::ParseConfig strictConfig() {
+	Json5::ParseConfig conf;
+	conf.strictJson = true;
+	return conf;
+}
+
+TEST(strictAcceptsJson) {
+	const char *doc =
+		"{\"a\": [1, -2.5e+3, 0, -0, 1E2], \"b\": \"\\u00e9\\n\\/\", "
+		"\"c\": {\"d\": [true, false, null]}, \"e\": {}, \"f\": []}";
+	CHECK_EQ(toJson(parseOk(doc, strictConfig())), toJson(parseOk(doc)));
+	CHECK_EQ(toJson(parseOk(" \t\r\n[1]\n", strictConfig())), "[1]");
+}
+
+TEST(strictRejectsJson5) {
+	for (const char *doc: {
+			"// comment\n1", "/* comment */ 1", "'single'", "{a: 1}", "[1,]", "{\"a\": 1,}",
+			"0x10", "Infinity", "-Infinity", "NaN", "+1", ".5", "5.", "01", "\"\\x41\"",
+			"\"a\\\nb\"", "\"\\'\"", "\"\\v\"", "[1\f]", "[1\v]", "[1\xc2\xa0]",
+			"\xef\xbb\xbf[1]", "[1\xe2\x80\xa8]", "\"\t\""}) {
+		Json::Value v;
+		if (Json5::parse(doc, strlen(doc), v, nullptr, strictConfig())) {
+			checkFailed(__FILE__, __LINE__, "Accepted '" + std::string(doc) + "'");
+		}
+
+		std::istringstream is(doc);
+		if (Json5::validate(is, nullptr, strictConfig())) {
+			checkFailed(__FILE__, __LINE__, "Validated '" + std::string(doc) + "'");
+		}
+	}
+}
+
+TEST(strictIgnoresNewlinesAsCommas) {
+	Json5::ParseConfig conf = strictConfig();
+	conf.newlinesAsCommas = true;
+	std::string err = parseErr("[1\n2]", conf);
+	CHECK_EQ(err, "2:1: Expected ',' or ']'");
+}
+
+TEST(strictPathsMalformedSkippedSubtree) {
+	// Skipped values are held to strict JSON too
+	std::vector<std::string> paths = {"/b"};
+	Json5::ParseConfig conf = strictConfig();
+	conf.paths = &paths;
+	for (const char *doc: {
+			"{\"a\": [1\f], \"b\": 1}", "{\"a\": [1\v], \"b\": 1}",
+			"{\"a\": [1\xc2\xa0], \"b\": 1}", "{\"a\": [\xe2\x80\xa8], \"b\": 1}",
+			"{\"a\": [\f], \"b\": 1}", "{\"a\": [/], \"b\": 1}",
+			"{\"a\": 'x', \"b\": 1}", "{\"a\": [1] // c\n, \"b\": 1}", "{\"a\": /* c */ 1, \"b\": 1}",
+			"{\"a\": Infinity, \"b\": 1}", "{\"a\": 0x10, \"b\": 1}", "{\"a\": +1, \"b\": 1}",
+			"{\"a\": {c: 1}, \"b\": 1}", "{\"a\": [1,], \"b\": 1}", "{\"a\": \"\\x41\", \"b\": 1}",
+			"{\"a\": \"\t\", \"b\": 1}"}) {
+		std::string err;
+		finishesWithin(5, doc, [&] { err = parseErr(doc, conf); });
+		CHECK_EQ(err, parseErr(doc, strictConfig()));
+	}
+
+	CHECK_EQ(toJson(parseOk("{\"a\": [1, {\"x\": \"]\"}], \"b\": 1}", conf)), "{\"b\":1}");
+}
@@ -0,0 +1,69 @@
+// A tiny test framework for the API tests, so that they don't need any dependencies.
+// Every test file includes this, and only json5cpp.cc has the implementation,
+// so the tests also check that everything works with JSON5CPP_FWD_ONLY.
+
+#ifndef JSON5CPP_TEST_H
+#define JSON5CPP_TEST_H
+
+#define JSON5CPP_FWD_ONLY
+#include "json5cpp.h"
+
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct TestCase {
+	const char *name;
+	void (*fn)();
+};
+
+std::vector<TestCase> &testCases();
+
+struct TestRegistration {
+	TestRegistration(const char *name, void (*fn)()) {
+		testCases().push_back(TestCase{name, fn});
+	}
+};
+
+#define TEST(name) \
+	static void test_##name(); \
+	static TestRegistration testRegistration_##name(#name, test_##name); \
+	static void test_##name()
+
+void checkFailed(const char *file, int line, const std::string &what);
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		checkFailed(__FILE__, __LINE__, #cond); \
+	} \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+	auto &&checkA_ = (a); \
+	auto &&checkB_ = (b); \
+	if (!(checkA_ == checkB_)) { \
+		std::ostringstream checkOs_; \
+		checkOs_ << #a " == " #b "\n    left:  " << checkA_ << "\n    right: " << checkB_; \
+		checkFailed(__FILE__, __LINE__, checkOs_.str()); \
+	} \
+} while (0)
+
+// Parse a document which must be valid
+Json::Value parseOk(const std::string &doc, Json5::ParseConfig conf = {});
+
+// Parse a document which must be invalid, and return the error message
+std::string parseErr(const std::string &doc, Json5::ParseConfig conf = {});
+
+// Serialize as compact JSON, which is easy to compare
+std::string toJson(const Json::Value &v);
+
+// Run 'fn', and fail the whole test run right away if it doesn't return
+// within 'seconds', since a hung parser can't be stopped.
+void finishesWithin(double seconds, const char *what, std::function<void()> fn);
+
+// A new, empty temporary directory, which is removed when the tests are done
+std::string tempDir();
+void writeFile(const std::string &path, const std::string &content);
+
+#endif
@@ -0,0 +1,145 @@
+#include "test.h"
+
+namespace {
+
+struct Point {
+	int x;
+	double y;
+};
+
+struct Shape {
+	std::string name;
+	std::vector<Point> points;
+	std::map<std::string, bool> flags;
+	Json::Value extra;
+};
+
+}
+
+namespace Json5 {
+
+template<>
+struct Fields<Point> {
+	template<typename F>
+	static void visit(const Point &p, F &f) {
+		f("x", p.x);
+		f("y", p.y);
+	}
+};
+
+template<>
+struct Fields<Shape> {
+	template<typename F>
+	static void visit(const Shape &s, F &f) {
+		f("extra", s.extra);
+		f("flags", s.flags);
+		f("name", s.name);
+		f("points", s.points);
+	}
+};
+
+}
+
+template<typename T>
+static std::string typed(const T &v, Json5::SerializeConfig conf = {}) {
+	std::ostringstream os;
+	Json5::serialize(os, v, conf);
+	return os.str();
+}
+
+static std::string untyped(const Json::Value &v, Json5::SerializeConfig conf = {}) {
+	std::ostringstream os;
+	Json5::serialize(os, v, conf);
+	return os.str();
+}
+
+static Shape makeShape() {
+	Shape s;
+	s.name = "tri\"angle\n";
+	s.points = {{1, 2.5}, {-3, 0.1}, {0, 1e300}};
+	s.flags["closed"] = true;
+	s.flags["hidden key"] = false;
+	s.extra["a"] = Json::Value(Json::arrayValue);
+	s.extra["b"] = Json::nullValue;
+	return s;
+}
+
+static Json::Value makeShapeValue() {
+	Json::Value v;
+	v["name"] = "tri\"angle\n";
+	Json::Value &points = v["points"] = Json::Value(Json::arrayValue);
+	Json::Value p;
+	p["x"] = 1;
+	p["y"] = 2.5;
+	points.append(p);
+	p["x"] = -3;
+	p["y"] = 0.1;
+	points.append(p);
+	p["x"] = 0;
+	p["y"] = 1e300;
+	points.append(p);
+	v["flags"]["closed"] = true;
+	v["flags"]["hidden key"] = false;
+	v["extra"]["a"] = Json::Value(Json::arrayValue);
+	v["extra"]["b"] = Json::nullValue;
+	return v;
+}
+
+TEST(typedScalars) {
+	CHECK_EQ(typed(true), "true");
+	CHECK_EQ(typed(false), "false");
+	CHECK_EQ(typed(-42), "-42");
+	CHECK_EQ(typed((short)-7), "-7");
+	CHECK_EQ(typed(4000000000u), "4000000000");
+	CHECK_EQ(typed((unsigned long long)18446744073709551615ull), "18446744073709551615");
+	CHECK_EQ(typed(0.5), untyped(0.5));
+	CHECK_EQ(typed(0.1f), untyped(double(0.1f)));
+	CHECK_EQ(typed(std::string("a\"b")), untyped("a\"b"));
+	CHECK_EQ(typed("hello"), "\"hello\"");
+	const char *str = "ptr";
+	CHECK_EQ(typed(str), "\"ptr\"");
+}
+
+TEST(typedMatchesValue) {
+	// The fields are visited in the Json::Value's sorted key order, so the output is identical
+	Json5::SerializeConfig conf;
+	CHECK_EQ(typed(makeShape(), conf), untyped(makeShapeValue(), conf));
+
+	conf.indent = nullptr;
+	conf.trailingCommas = false;
+	conf.bareKeys = false;
+	CHECK_EQ(typed(makeShape(), conf), untyped(makeShapeValue(), conf));
+	CHECK_EQ(typed(makeShape(), conf), toJson(makeShapeValue()));
+
+	conf.indent = "  ";
+	conf.trailingCommas = true;
+	conf.bareKeys = true;
+	CHECK_EQ(typed(makeShape(), conf), untyped(makeShapeValue(), conf));
+}
+
+TEST(typedEmptyContainers) {
+	CHECK_EQ(typed(std::vector<int>()), untyped(Json::Value(Json::arrayValue)));
+	CHECK_EQ(typed(std::map<std::string, int>()), untyped(Json::Value(Json::objectValue)));
+
+	Shape s;
+	CHECK_EQ(typed(s), "{\n\textra: null,\n\tflags: {},\n\tname: \"\",\n\tpoints: [],\n}");
+}
+
+TEST(typedNestedContainers) {
+	std::map<std::string, std::vector<std::vector<int>>> m;
+	m["a"] = {{1, 2}, {}, {3}};
+	m["b-c"] = {};
+
+	Json::Value v;
+	v["a"][0][0] = 1;
+	v["a"][0][1] = 2;
+	v["a"][1] = Json::Value(Json::arrayValue);
+	v["a"][2][0] = 3;
+	v["b-c"] = Json::Value(Json::arrayValue);
+	CHECK_EQ(typed(m), untyped(v));
+}
+
+TEST(typedRoundTrip) {
+	Json::Value v = parseOk(typed(makeShape()));
+	CHECK_EQ(toJson(v), toJson(makeShapeValue()));
+}
@@ -0,0 +1,166 @@
+#include "test.h"
+
+static Json5::ParseConfig utf8Config() {
+	Json5::ParseConfig conf;
+	conf.validateUtf8 = true;
+	return conf;
+}
+
+static bool isValid(const std::string &str) {
+	Json::Value v;
+	return Json5::parse(str.data(), str.size(), v, nullptr, utf8Config());
+}
+
+TEST(utf8Valid) {
+	for (const char *str: {
+			"'ascii'", "'\xc3\xa9'", "'\xe2\x82\xac'", "'\xf0\x9f\x98\x80'",
+			"'\xed\x9f\xbf'", "'\xee\x80\x80'", "'\xf4\x8f\xbf\xbf'", "'\xc2\x80'",
+			"{\xc3\xa9t\xc3\xa9: 1}", "\"\xe4\xb8\xad\xe6\x96\x87\""}) {
+		CHECK(isValid(str));
+	}
+
+	Json::Value v = parseOk("'\xf0\x9f\x98\x80 and \xc3\xa9'", utf8Config());
+	CHECK_EQ(v.asString(), "\xf0\x9f\x98\x80 and \xc3\xa9");
+}
+
+TEST(utf8Invalid) {
+	for (const char *str: {
+			"'\x80'", "'\xbf'", "'\xc3'", "'\xc3\x28'", "'\xe2\x82'", "'\xf0\x9f\x98'",
+			// Overlong encodings
+			"'\xc0\x80'", "'\xc1\xbf'", "'\xe0\x80\x80'", "'\xe0\x9f\xbf'", "'\xf0\x80\x80\x80'",
+			"'\xf0\x8f\xbf\xbf'",
+			// Surrogates
+			"'\xed\xa0\x80'", "'\xed\xbf\xbf'",
+			// Above U+10FFFF
+			"'\xf4\x90\x80\x80'", "'\xf5\x80\x80\x80'", "'\xff'", "'\xfe'",
+			// Identifiers
+			"{\xc3: 1}", "{a\xed\xa0\x80: 1}"}) {
+		Json5::ParseConfig conf = utf8Config();
+		Json5::ParseError error;
+		conf.error = &error;
+		Json::Value v;
+		if (Json5::parse(str, strlen(str), v, nullptr, conf)) {
+			checkFailed(__FILE__, __LINE__, "Accepted invalid UTF-8 '" + std::string(str) + "'");
+		} else if (str[0] == '\'') {
+			CHECK_EQ(error.code, Json5::ERROR_INVALID_UTF8);
+		}
+
+		// It's only checked when it's asked for
+		if (str[0] == '\'') {
+			CHECK(Json5::parse(str, strlen(str), v));
+		}
+	}
+}
+
+TEST(utf8InvalidInLongStrings) {
+	// Put the invalid byte at every position relative to the bulk scanning blocks
+	for (size_t pos = 0; pos < 70; ++pos) {
+		std::string str = "'" + std::string(80, 'a') + "'";
+		str[1 + pos] = '\xff';
+
+		Json5::ParseConfig conf = utf8Config();
+		Json5::ParseError error;
+		conf.error = &error;
+		Json::Value v;
+		CHECK(!Json5::parse(str.data(), str.size(), v, nullptr, conf));
+		CHECK_EQ(error.code, Json5::ERROR_INVALID_UTF8);
+		CHECK_EQ(error.offset, 1 + pos);
+
+		// A valid multi-byte sequence at the same position is fine
+		str = "'" + std::string(80, 'a') + "'";
+		str.replace(1 + pos, 3, "\xe2\x82\xac");
+		CHECK(isValid(str));
+		CHECK_EQ(parseOk(str, utf8Config()).asString(), str.substr(1, str.size() - 2));
+	}
+}
+
+TEST(utf8Validate) {
+	std::istringstream valid("['\xc3\xa9', {\xc3\xa9: 1}]");
+	CHECK(Json5::validate(valid, nullptr, utf8Config()));
+	std::istringstream invalid("['\xc3\xa9', '\xed\xa0\x80']");
+	CHECK(!Json5::validate(invalid, nullptr, utf8Config()));
+}
+
+// The offset of the first invalid sequence in 'str', or npos, one sequence at a time
+static size_t firstInvalid(const std::string &str) {
+	size_t i = 0;
+	while (i < str.size()) {
+		unsigned char a = str[i];
+		size_t len = a < 0x80 ? 1 : a >= 0xc2 && a <= 0xdf ? 2 : a >= 0xe0 && a <= 0xef ? 3 : a >= 0xf0 && a <= 0xf4 ? 4 : 0;
+		if (len == 0 || i + len > str.size()) {
+			return i;
+		}
+
+		unsigned char b = str[i + 1];
+		if (
+				(a == 0xe0 && b < 0xa0) || (a == 0xed && b > 0x9f) ||
+				(a == 0xf0 && b < 0x90) || (a == 0xf4 && b > 0x8f)) {
+			return i;
+		}
+
+		for (size_t j = 1; j < len; ++j) {
+			if ((str[i + j] & 0xc0) != 0x80) {
+				return i;
+			}
+		}
+
+		i += len;
+	}
+
+	return std::string::npos;
+}
+
+TEST(utf8InvalidInNonAsciiText) {
+	// Mostly non-ASCII text, with an invalid sequence at every position
+	// relative to the blocks the scanner checks at once
+	const char *text =
+		"Bl\xc3\xa5" "b\xc3\xa6rsyltet\xc3\xb8y \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e "
+		"\xf0\x9f\x98\x80\xf0\x9f\x98\x80 \xe2\x82\xac\xc2\xa9\xed\x9f\xbf\xf4\x8f\xbf\xbf";
+	std::string base;
+	while (base.size() < 100) {
+		base += text;
+	}
+
+	for (const char *bad: {
+			"\x80", "\xc3", "\xe2\x82", "\xf0\x9f\x98", "\xc0\x80", "\xe0\x9f\xbf",
+			"\xed\xa0\x80", "\xf0\x8f\xbf\xbf", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xff"}) {
+		for (size_t pos = 0; pos < 64; ++pos) {
+			std::string content = base;
+			content.insert(pos, bad);
+			size_t expected = firstInvalid(content);
+			std::string doc = "[\"" + content + "\"]";
+
+			Json5::ParseConfig conf = utf8Config();
+			Json5::ParseError error;
+			conf.error = &error;
+			Json::Value v;
+			if (expected == std::string::npos) {
+				// Inserting it in the middle of a sequence can leave it valid
+				CHECK(Json5::parse(doc.data(), doc.size(), v, nullptr, conf));
+				continue;
+			}
+
+			CHECK(!Json5::parse(doc.data(), doc.size(), v, nullptr, conf));
+			CHECK_EQ(error.code, Json5::ERROR_INVALID_UTF8);
+			CHECK_EQ(error.offset, 2 + expected);
+		}
+	}
+
+	CHECK_EQ(parseOk("[\"" + base + "\"]", utf8Config())[0].asString(), base);
+}
+
+TEST(utf8SkippedByPaths) {
+	// Skipped values are validated too, so paths don't change what's accepted
+	std::vector<std::string> paths = {"/b"};
+	Json5::ParseConfig conf = utf8Config();
+	conf.paths = &paths;
+	for (const char *doc: {
+			"{a: '\xed\xa0\x80', b: 1}", "{a: ['ok', {c: '\xc3'}], b: 1}",
+			"{a: {\xc3: 1}, b: 1}", "{a: \"x\\\xff\", b: 1}"}) {
+		std::string err = parseErr(doc, conf);
+		CHECK(err.find("Invalid UTF-8") != std::string::npos);
+		CHECK_EQ(err, parseErr(doc, utf8Config()));
+	}
+
+	CHECK_EQ(toJson(parseOk("{a: '\xc3\xa9', b: 1}", conf)), "{\"b\":1}");
+}
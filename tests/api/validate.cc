@@ -0,0 +1,87 @@
+#include "test.h"
+
+// Documents which exercise every kind of value and most errors
+static const char *const documents[] = {
+	"null", "true", "false", "0", "-0", "1.5e3", ".5", "5.", "+1", "0x1F", "-0xff",
+	"Infinity", "-Infinity", "NaN", "'single'", "\"double\"", "'\\x41\\u00e9\\n'",
+	"\"\\uD83D\\uDE00\"", "[]", "{}", "[1, 2, 3,]", "{a: 1, 'b': 2, \"c\": 3,}",
+	"{$_a\\u0062: [{}, [[]], {x: {y: null}}]}", "// comment\n1 /* block */",
+	"\xef\xbb\xbf{}", "{\xe2\x80\xa8" "a: 1}", "[1,\n2\n]",
+	"", " ", "nul", "tru", "01", "1e", "0x", "--1", "[1 2]", "{a 1}", "{a: 1 b: 2}",
+	"{1: 2}", "[,]", "{,}", "[1,,2]", "'abc", "\"a\nb\"", "'\\u12'", "'\\uD800'",
+	"'\\uD800\\u0041'", "[", "]", "{", "}", "1 2", "/* x", "/ 1", "{a: [}",
+	"[1]]", "\"\\x4\"", "{a\\u0030: 1}", "{\\u0030a: 1}", "\x01", "'\x01'",
+	"[1\n2]", "{a: 1\nb: 2}", "'\xff'", "'\xc0\x80'", "'\xed\xa0\x80'", "{\xc3\xa9: 1}",
+};
+
+static void checkSameAsParse(Json5::ParseConfig conf) {
+	for (const char *doc: documents) {
+		std::string parseError;
+		Json::Value v;
+		bool parseOk = Json5::parse(doc, strlen(doc), v, &parseError, conf);
+
+		std::string validateError;
+		std::istringstream is(doc);
+		bool validateOk = Json5::validate(is, &validateError, conf);
+
+		Json5::Parser parser(conf);
+		std::string parserError;
+		bool parserOk = parser.validate(doc, strlen(doc), &parserError);
+
+		if (validateOk != parseOk || validateError != parseError) {
+			checkFailed(__FILE__, __LINE__,
+				"Validating '" + std::string(doc) + "' gave '" + validateError +
+				"', parsing gave '" + parseError + "'");
+		}
+
+		if (parserOk != parseOk || parserError != parseError) {
+			checkFailed(__FILE__, __LINE__,
+				"Parser::validate of '" + std::string(doc) + "' gave '" + parserError +
+				"', parsing gave '" + parseError + "'");
+		}
+	}
+}
+
+TEST(validateMatchesParse) {
+	checkSameAsParse({});
+}
+
+TEST(validateMatchesParseNewlinesAsCommas) {
+	Json5::ParseConfig conf;
+	conf.newlinesAsCommas = true;
+	checkSameAsParse(conf);
+}
+
+TEST(validateMatchesParseStrict) {
+	Json5::ParseConfig conf;
+	conf.strictJson = true;
+	checkSameAsParse(conf);
+}
+
+TEST(validateMatchesParseUtf8) {
+	Json5::ParseConfig conf;
+	conf.validateUtf8 = true;
+	checkSameAsParse(conf);
+}
+
+TEST(validateIgnoresPaths) {
+	Json5::ParseConfig conf;
+	std::vector<std::string> paths = {"/a"};
+	conf.paths = &paths;
+	std::istringstream is("{a: 1, b: [1 2]}");
+	std::string err;
+	CHECK(!Json5::validate(is, &err, conf));
+	CHECK_EQ(err, "1:14: Expected ',' or ']'");
+}
+
+TEST(validateDepthLimit) {
+	Json5::ParseConfig conf;
+	conf.maxDepth = 5;
+	std::istringstream ok("[[[[[]]]]]");
+	CHECK(Json5::validate(ok, nullptr, conf));
+	std::istringstream deep("[[[[[[]]]]]]");
+	Json5::ParseError error;
+	conf.error = &error;
+	CHECK(!Json5::validate(deep, nullptr, conf));
+	CHECK_EQ(error.code, Json5::ERROR_DEPTH_LIMIT);
+}
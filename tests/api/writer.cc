@@ -0,0 +1,132 @@
+#include "test.h"
+
+static std::string serialized(const Json::Value &v, Json5::SerializeConfig conf, int depth = 0) {
+	std::ostringstream os;
+	Json5::serialize(os, v, conf, depth);
+	return os.str();
+}
+
+static std::string written(Json5::SerializeConfig conf, int depth = 0) {
+	std::ostringstream os;
+	Json5::Writer w(os, conf, depth);
+	w.beginObject();
+	w.key("name");
+	w.value("writer");
+	w.key(std::string("list"));
+	w.beginArray();
+	w.value(1);
+	w.value(2.5);
+	w.beginObject();
+	w.endObject();
+	w.beginArray();
+	w.endArray();
+	w.value(std::vector<int>{3, 4});
+	w.endArray();
+	w.key("needs quotes");
+	w.value(true);
+	w.key("nested");
+	w.beginObject();
+	w.key("v");
+	w.value(Json::Value());
+	w.endObject();
+	w.endObject();
+	return os.str();
+}
+
+static Json::Value equivalent() {
+	Json::Value v;
+	v["name"] = "writer";
+	v["list"][0] = 1;
+	v["list"][1] = 2.5;
+	v["list"][2] = Json::Value(Json::objectValue);
+	v["list"][3] = Json::Value(Json::arrayValue);
+	v["list"][4][0] = 3;
+	v["list"][4][1] = 4;
+	v["needs quotes"] = true;
+	v["nested"]["v"] = Json::nullValue;
+	return v;
+}
+
+TEST(writerMatchesSerialize) {
+	Json5::SerializeConfig conf;
+	std::string out = written(conf);
+	CHECK_EQ(toJson(parseOk(out)), toJson(equivalent()));
+
+	// With the keys in the Json::Value's sorted order, the output is identical
+	Json::Value sorted = equivalent();
+	std::ostringstream os;
+	Json5::Writer w(os, conf);
+	w.beginObject();
+	for (const std::string &key: sorted.getMemberNames()) {
+		w.key(key);
+		w.value(sorted[key]);
+	}
+	w.endObject();
+	CHECK_EQ(os.str(), serialized(sorted, conf));
+}
+
+TEST(writerConfigs) {
+	Json5::SerializeConfig conf;
+	conf.indent = nullptr;
+	conf.trailingCommas = false;
+	conf.bareKeys = false;
+	CHECK_EQ(written(conf),
+		"{\"name\":\"writer\",\"list\":[1,2.5,{},[],[3,4]],"
+		"\"needs quotes\":true,\"nested\":{\"v\":null}}");
+
+	conf.indent = "  ";
+	conf.trailingCommas = true;
+	conf.bareKeys = true;
+	CHECK_EQ(toJson(parseOk(written(conf, 2))), toJson(equivalent()));
+}
+
+TEST(writerScalarRoot) {
+	std::ostringstream os;
+	Json5::Writer w(os);
+	w.value("just a string");
+	CHECK_EQ(os.str(), "\"just a string\"");
+}
+
+TEST(writerNested) {
+	for (int depth: {0, 1, 3}) {
+		Json::Value v;
+		v[0][0]["a"][0] = 1;
+		v[0][1] = Json::Value(Json::objectValue);
+		v[1] = "x";
+
+		std::ostringstream os;
+		Json5::SerializeConfig conf;
+		Json5::Writer w(os, conf, depth);
+		w.beginArray();
+		w.beginArray();
+		w.beginObject();
+		w.key("a");
+		w.beginArray();
+		w.value(1);
+		w.endArray();
+		w.endObject();
+		w.beginObject();
+		w.endObject();
+		w.endArray();
+		w.value("x");
+		w.endArray();
+		CHECK_EQ(os.str(), serialized(v, conf, depth));
+	}
+}
+
+TEST(writerBigArray) {
+	// Only the nesting is kept in memory, so this doesn't build a big value
+	std::ostringstream os;
+	Json5::SerializeConfig conf;
+	conf.indent = nullptr;
+	Json5::Writer w(os, conf);
+	w.beginArray();
+	for (int i = 0; i < 10000; ++i) {
+		w.value(i);
+	}
+	w.endArray();
+
+	Json::Value v = parseOk(os.str());
+	CHECK_EQ(v.size(), 10000u);
+	CHECK_EQ(v[9999].asInt(), 9999);
+}
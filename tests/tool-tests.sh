@@ -0,0 +1,67 @@
+#!/bin/sh
+# Tests for the json5cpp command line tool.
+# Usage: ./tool-tests.sh <path to json5cpp>
+
+tool="$1"
+tmp="$(mktemp -d)"
+trap 'rm -rf "$tmp"' EXIT
+
+succeeded=0
+total=0
+
+check() {
+	total=$((total + 1))
+	if [ "$2" = "$3" ]; then
+		succeeded=$((succeeded + 1))
+	else
+		echo "Failed: $1"
+		echo "  expected: $3"
+		echo "  got:      $2"
+	fi
+}
+
+check "convert" \
+	"$(echo "{a: [1, 'x'], b: null}" | "$tool" --compact)" \
+	'{"a":[1,"x"],"b":null}'
+
+check "ndjson" \
+	"$(printf "{a: 1}\n\n[2,]\n" | "$tool" --ndjson)" \
+	"$(printf '{"a":1}\n[2]')"
+
+printf "{a: 1}\n[2\n3\n" >"$tmp/bad.ndjson"
+out="$("$tool" --ndjson "$tmp/bad.ndjson" 2>"$tmp/err")"
+check "ndjson errors exit status" "$?" 1
+check "ndjson errors output" "$out" "$(printf '{"a":1}\n3')"
+check "ndjson errors" "$(cat "$tmp/err")" "$tmp/bad.ndjson:2: 1:3: Unexpected EOF"
+
+# Many jobs with more threads than cores: output stays in order, and workers
+# waiting for the writer to catch up don't deadlock
+i=0
+while [ $i -lt 200000 ]; do
+	echo "{n: $i, s: 'padding padding padding padding'}"
+	i=$((i + 1))
+done >"$tmp/big.ndjson"
+for threads in 1 3 8; do
+	"$tool" --ndjson --threads $threads "$tmp/big.ndjson" >"$tmp/out" &
+	pid=$!
+	( sleep 60; kill $pid 2>/dev/null ) &
+	watchdog=$!
+	wait $pid
+	status=$?
+	kill $watchdog 2>/dev/null
+	check "ndjson --threads $threads exit status" "$status" 0
+	check "ndjson --threads $threads order" \
+		"$(sed -n 's/^{"n":\([0-9]*\),.*/\1/p' "$tmp/out" | awk '$1 != NR - 1 { print "line " NR ": " $1; exit }')" ""
+	check "ndjson --threads $threads count" "$(wc -l <"$tmp/out" | tr -d ' ')" 200000
+done
+
+for threads in -1 abc 2x "" 99999999999999999999; do
+	out="$("$tool" --threads "$threads" "$tmp/big.ndjson" 2>&1)"
+	check "--threads '$threads' exit status" "$?" 1
+	check "--threads '$threads' message" "$out" "Invalid thread count: '$threads'"
+done
+
+check "--threads 0" "$(echo "[1]" | "$tool" --threads 0 --compact)" "[1]"
+
+echo "$succeeded/$total tool tests succeeded."
+[ $succeeded -eq $total ]
@@ -0,0 +1,389 @@
+#include "json5cpp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char *usage =
+	"Usage: json5cpp [options] [files...]\n"
+	"Converts JSON5 documents to JSON (or JSON5) on stdout.\n"
+	"With no files, or with '-', stdin is read.\n"
+	"\n"
+	"Options:\n"
+	"  --json5                Write JSON5 instead of JSON\n"
+	"  --ndjson               Treat the input as one document per line,\n"
+	"                         and write one document per line\n"
+	"  --threads <n>          Number of threads, 0 for one per core (default 0)\n"
+	"  --stats                Print throughput to stderr\n"
+	"  --newlines-as-commas   Accept newlines instead of commas\n"
+	"  --strict-json          Only accept standard JSON\n"
+	"  --no-trailing-commas   Don't write trailing commas (JSON5 output)\n"
+	"  --no-bare-keys         Always quote keys (JSON5 output)\n"
+	"  --indent <str>         The string to indent with (default tab)\n"
+	"  --compact              Don't write any whitespace\n"
+	"  --help                 Show this help text\n";
+
+// An input file, mapped into memory when possible
+struct Input {
+	~Input() {
+		if (mapping) {
+			munmap(mapping, size);
+		}
+	}
+
+	std::string name;
+	const char *data = nullptr;
+	size_t size = 0;
+	void *mapping = nullptr;
+	std::string buffer; // For stdin, pipes and other files which can't be mapped
+};
+
+// A piece of work: a whole document, or a run of NDJSON lines
+struct Job {
+	Job(const Input *input, const char *data, size_t size, size_t firstLine):
+		input(input), data(data), size(size), firstLine(firstLine) {}
+
+	const Input *input;
+	const char *data;
+	size_t size;
+	size_t firstLine;
+
+	std::string out;
+	std::string errors;
+	size_t records = 0;
+	bool failed = false;
+	bool done = false;
+};
+
+static bool readAll(int fd, std::string &buffer) {
+	char buf[64 * 1024];
+	while (true) {
+		ssize_t n = read(fd, buf, sizeof(buf));
+		if (n < 0) {
+			return false;
+		} else if (n == 0) {
+			return true;
+		}
+
+		buffer.append(buf, n);
+	}
+}
+
+static bool openInput(const char *path, Input &in) {
+	in.name = path;
+	if (strcmp(path, "-") == 0) {
+		in.name = "<stdin>";
+		if (!readAll(STDIN_FILENO, in.buffer)) {
+			return false;
+		}
+
+		in.data = in.buffer.data();
+		in.size = in.buffer.size();
+		return true;
+	}
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+		void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapping != MAP_FAILED) {
+			madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+			close(fd);
+			in.mapping = mapping;
+			in.data = (const char *)mapping;
+			in.size = st.st_size;
+			return true;
+		}
+	}
+
+	bool ok = readAll(fd, in.buffer);
+	close(fd);
+	in.data = in.buffer.data();
+	in.size = in.buffer.size();
+	return ok;
+}
+
+// Split NDJSON input into jobs of about 'chunkSize' bytes, on line boundaries
+static void splitLines(const Input &in, size_t chunkSize, std::vector<Job> &jobs) {
+	size_t line = 1;
+	size_t pos = 0;
+	while (pos < in.size) {
+		size_t end = std::min(pos + chunkSize, in.size);
+		const char *nl = (const char *)memchr(in.data + end, '\n', in.size - end);
+		end = nl ? nl - in.data + 1 : in.size;
+
+		jobs.emplace_back(&in, in.data + pos, end - pos, line);
+		line += std::count(in.data + pos, in.data + end, '\n');
+		pos = end;
+	}
+}
+
+static void convert(
+		Json5::Parser &parser, const char *data, size_t size,
+		std::ostringstream &os, const Json5::SerializeConfig &sconf,
+		const std::string &where, Job &job) {
+	Json::Value v;
+	std::string err;
+	if (!parser.parse(data, size, v, &err)) {
+		job.errors += where;
+		job.errors += ": ";
+		job.errors += err;
+		job.errors += '\n';
+		job.failed = true;
+		return;
+	}
+
+	Json5::serialize(os, v, sconf);
+	os << '\n';
+	job.records += 1;
+}
+
+static void runJob(
+		Json5::Parser &parser, Job &job,
+		const Json5::SerializeConfig &sconf, bool ndjson) {
+	std::ostringstream os;
+	if (!ndjson) {
+		convert(parser, job.data, job.size, os, sconf, job.input->name, job);
+		job.out = os.str();
+		return;
+	}
+
+	size_t lineNum = job.firstLine;
+	const char *pos = job.data;
+	const char *end = job.data + job.size;
+	while (pos < end) {
+		const char *nl = (const char *)memchr(pos, '\n', end - pos);
+		const char *lineEnd = nl ? nl : end;
+		const char *contentEnd = lineEnd;
+		if (contentEnd > pos && contentEnd[-1] == '\r') {
+			contentEnd -= 1;
+		}
+
+		// Skip blank lines
+		const char *p = pos;
+		while (p < contentEnd && (*p == ' ' || *p == '\t')) {
+			p += 1;
+		}
+
+		if (p < contentEnd) {
+			convert(
+				parser, pos, contentEnd - pos, os, sconf,
+				job.input->name + ':' + std::to_string(lineNum), job);
+		}
+
+		lineNum += 1;
+		pos = lineEnd + 1;
+	}
+
+	job.out = os.str();
+}
+
+// Parse a non-negative decimal number, rejecting signs, junk and overflow
+static bool parseCount(const char *str, unsigned int &count) {
+	if (*str < '0' || *str > '9') {
+		return false;
+	}
+
+	errno = 0;
+	char *end;
+	unsigned long n = strtoul(str, &end, 10);
+	if (*end != '\0' || errno == ERANGE || n > UINT_MAX) {
+		return false;
+	}
+
+	count = (unsigned int)n;
+	return true;
+}
+
+int main(int argc, char **argv) {
+	Json5::ParseConfig pconf;
+	Json5::SerializeConfig sconf;
+	sconf.trailingCommas = false;
+	sconf.bareKeys = false;
+	bool json5 = false;
+	bool trailingCommas = true;
+	bool bareKeys = true;
+	bool ndjson = false;
+	bool stats = false;
+	unsigned int threads = 0;
+	std::vector<const char *> paths;
+
+	for (int i = 1; i < argc; ++i) {
+		char *opt = argv[i];
+		if (strcmp(opt, "--json5") == 0) {
+			json5 = true;
+		} else if (strcmp(opt, "--ndjson") == 0) {
+			ndjson = true;
+		} else if (strcmp(opt, "--stats") == 0) {
+			stats = true;
+		} else if (strcmp(opt, "--newlines-as-commas") == 0) {
+			pconf.newlinesAsCommas = true;
+		} else if (strcmp(opt, "--strict-json") == 0) {
+			pconf.strictJson = true;
+		} else if (strcmp(opt, "--no-trailing-commas") == 0) {
+			trailingCommas = false;
+		} else if (strcmp(opt, "--no-bare-keys") == 0) {
+			bareKeys = false;
+		} else if (strcmp(opt, "--compact") == 0) {
+			sconf.indent = nullptr;
+			trailingCommas = false;
+		} else if (strcmp(opt, "--indent") == 0 || strcmp(opt, "--threads") == 0) {
+			if (i >= argc - 1) {
+				std::cerr << "'" << opt << "' requires an argument\n";
+				return 1;
+			}
+
+			if (strcmp(opt, "--indent") == 0) {
+				sconf.indent = argv[i + 1];
+			} else if (!parseCount(argv[i + 1], threads)) {
+				std::cerr << "Invalid thread count: '" << argv[i + 1] << "'\n";
+				return 1;
+			}
+			i += 1;
+		} else if (strcmp(opt, "--help") == 0) {
+			std::cout << usage;
+			return 0;
+		} else if (opt[0] == '-' && opt[1] != '\0') {
+			std::cerr << "Unknown option: '" << opt << "'\n";
+			return 1;
+		} else {
+			paths.push_back(opt);
+		}
+	}
+
+	if (paths.empty()) {
+		paths.push_back("-");
+	}
+
+	if (json5) {
+		sconf.trailingCommas = trailingCommas;
+		sconf.bareKeys = bareKeys;
+	}
+
+	// Every record has to stay on its own line
+	if (ndjson) {
+		sconf.indent = nullptr;
+		sconf.trailingCommas = false;
+	}
+
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	auto start = std::chrono::steady_clock::now();
+
+	std::vector<std::unique_ptr<Input>> inputs;
+	std::vector<Job> jobs;
+	size_t totalBytes = 0;
+	bool failed = false;
+	for (const char *path: paths) {
+		std::unique_ptr<Input> in(new Input);
+		if (!openInput(path, *in)) {
+			std::cerr << "Couldn't read " << path << ": " << strerror(errno) << '\n';
+			failed = true;
+			continue;
+		}
+
+		totalBytes += in->size;
+		if (ndjson) {
+			splitLines(*in, 256 * 1024, jobs);
+		} else {
+			jobs.emplace_back(in.get(), in->data, in->size, 1);
+		}
+
+		inputs.push_back(std::move(in));
+	}
+
+	// A single big document gets the threads for serializing instead
+	if (jobs.size() == 1) {
+		sconf.threads = threads;
+	}
+
+	// Workers take jobs in order, the main thread writes their output in order.
+	// Workers stay at most 'maxAhead' jobs ahead of the writer, so that a slow
+	// job or a slow stdout doesn't pile up converted output in memory.
+	std::mutex mut;
+	std::condition_variable cond;
+	std::atomic<size_t> next{0};
+	size_t written = 0;
+	std::vector<std::thread> workers;
+	unsigned int numWorkers = std::max<size_t>(1, std::min<size_t>(threads, jobs.size()));
+	size_t maxAhead = 2 * (size_t)numWorkers;
+	for (unsigned int i = 0; i < numWorkers; ++i) {
+		workers.emplace_back([&] {
+			Json5::Parser parser(pconf);
+			size_t index;
+			while ((index = next++) < jobs.size()) {
+				{
+					std::unique_lock<std::mutex> lock(mut);
+					cond.wait(lock, [&] { return index < written + maxAhead; });
+				}
+
+				runJob(parser, jobs[index], sconf, ndjson);
+				std::lock_guard<std::mutex> lock(mut);
+				jobs[index].done = true;
+				cond.notify_all();
+			}
+		});
+	}
+
+	static char outBuf[256 * 1024];
+	setvbuf(stdout, outBuf, _IOFBF, sizeof(outBuf));
+
+	size_t records = 0;
+	for (Job &job: jobs) {
+		{
+			std::unique_lock<std::mutex> lock(mut);
+			cond.wait(lock, [&] { return job.done; });
+		}
+
+		fwrite(job.out.data(), 1, job.out.size(), stdout);
+		fputs(job.errors.c_str(), stderr);
+		records += job.records;
+		failed = failed || job.failed;
+		std::string().swap(job.out);
+		std::string().swap(job.errors);
+
+		std::lock_guard<std::mutex> lock(mut);
+		written += 1;
+		cond.notify_all();
+	}
+
+	for (std::thread &worker: workers) {
+		worker.join();
+	}
+
+	if (fflush(stdout) != 0) {
+		std::cerr << "Couldn't write output: " << strerror(errno) << '\n';
+		failed = true;
+	}
+
+	if (stats) {
+		std::chrono::duration<double> delta = std::chrono::steady_clock::now() - start;
+		double secs = std::max(delta.count(), 1e-9);
+		fprintf(
+			stderr, "%zu records, %.1f MB in %.3fs: %.1f MB/s, %.0f records/s (%u threads)\n",
+			records, totalBytes / 1e6, secs, totalBytes / 1e6 / secs, records / secs,
+			numWorkers);
+	}
+
+	return failed ? 1 : 0;
+}